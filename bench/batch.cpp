@@ -0,0 +1,57 @@
+#include <paket_batch.hpp>
+
+#include "bench.hpp"
+
+#include <thread>
+
+using namespace handtruth::pakets;
+
+struct position_paket : paket<0x11, fields::varint, fields::zint<std::int64_t>, fields::zint<std::int64_t>, fields::zint<std::int64_t>, fields::boolean> {};
+struct chat_paket : paket<0x0F, fields::string, fields::byte> {};
+
+// threads inherit the CPU affinity, so run without PAKET_BENCH_CPU to see scaling
+benchmark {
+	const std::size_t count = 20000;
+	auto values = ::bench::realistic_values<std::int64_t>(count * 3);
+	std::vector<byte_t> wire;
+	for (std::size_t i = 0; i < count; ++i) {
+		byte_t bytes[64];
+		position_paket p;
+		p.field<0>() = static_cast<std::int32_t>(i);
+		p.field<1>() = values[i * 3];
+		p.field<2>() = values[i * 3 + 1];
+		p.field<3>() = values[i * 3 + 2];
+		p.field<4>() = i % 2 == 0;
+		int size = p.write(bytes, sizeof(bytes));
+		wire.insert(wire.end(), bytes, bytes + size);
+	}
+
+	std::vector<frame> frames;
+	frames.reserve(count);
+	suite.run("scan_frames", count, wire.size(), [&]() {
+		frames.clear();
+		::bench::keep(scan_frames(wire.data(), wire.size(), frames));
+	});
+
+	unsigned hardware = std::max(std::thread::hardware_concurrency(), 1u);
+	for (unsigned threads = 1; threads <= hardware; threads *= 2) {
+		batch_decoder decoder(threads);
+		suite.run("decode_all_" + std::to_string(threads) + "_threads", count, wire.size(), [&]() {
+			::bench::keep(decoder.decode_all<position_paket>(frames).size());
+		});
+	}
+	std::vector<byte_t> text;
+	for (std::size_t i = 0; i < count / 10; ++i) {
+		byte_t bytes[300];
+		chat_paket p;
+		p.field<0>() = ::bench::random_text(50 + i % 200, static_cast<std::uint32_t>(i));
+		int size = p.write(bytes, sizeof(bytes));
+		text.insert(text.end(), bytes, bytes + size);
+	}
+	std::vector<frame> chats;
+	scan_frames(text.data(), text.size(), chats);
+	batch_decoder decoder(hardware);
+	suite.run("decode_all_chat", chats.size(), text.size(), [&]() {
+		::bench::keep(decoder.decode_all<chat_paket>(chats).size());
+	});
+}
@@ -0,0 +1,280 @@
+#ifdef __BENCH_HEAD
+#   error "bench.hpp header can't be included several times"
+#else
+#   define __BENCH_HEAD
+#endif
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <random>
+
+#if defined(__linux__) && __has_include(<linux/perf_event.h>)
+#   define BENCH_PERF_EVENTS
+#   include <linux/perf_event.h>
+#   include <sys/ioctl.h>
+#   include <sys/syscall.h>
+#   include <unistd.h>
+#   include <sched.h>
+#endif
+
+namespace bench {
+
+/**
+ * Prevents the compiler from optimizing away the computation of the value.
+ */
+template <typename T>
+inline void keep(const T & value) {
+#   ifdef __GNUC__
+        asm volatile("" : : "r,m"(value) : "memory");
+#   else
+        static volatile const T * sink;
+        sink = &value;
+#   endif
+}
+
+/**
+ * Hardware counters of the current thread read with perf_event_open.
+ * Counters that the kernel does not allow to open are not available.
+ */
+class counters {
+public:
+    static constexpr int count = 3;
+    static constexpr const char * names[count] = { "instructions", "branch_misses", "cache_misses" };
+
+private:
+    int fds[count] = { -1, -1, -1 };
+
+public:
+    counters() {
+#       ifdef BENCH_PERF_EVENTS
+            const std::uint64_t configs[count] = {
+                PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_MISSES
+            };
+            for (int i = 0; i < count; ++i) {
+                perf_event_attr attr {};
+                attr.size = sizeof(attr);
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = configs[i];
+                attr.disabled = 1;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            }
+#       endif
+    }
+    counters(const counters &) = delete;
+    counters & operator=(const counters &) = delete;
+    ~counters() {
+#       ifdef BENCH_PERF_EVENTS
+            for (int fd : fds)
+                if (fd >= 0)
+                    close(fd);
+#       endif
+    }
+    bool available(int i) const noexcept {
+        return fds[i] >= 0;
+    }
+    void start() noexcept {
+#       ifdef BENCH_PERF_EVENTS
+            for (int fd : fds)
+                if (fd >= 0) {
+                    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+                }
+#       endif
+    }
+    void stop(std::uint64_t values[count]) noexcept {
+        for (int i = 0; i < count; ++i) {
+            values[i] = 0;
+#           ifdef BENCH_PERF_EVENTS
+                if (fds[i] >= 0) {
+                    ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+                    if (::read(fds[i], &values[i], sizeof(values[i])) != sizeof(values[i]))
+                        values[i] = 0;
+                }
+#           endif
+        }
+    }
+};
+
+/**
+ * Pins the current thread to the CPU from PAKET_BENCH_CPU environment
+ * variable, so measurements are not disturbed by migrations.
+ */
+inline void pin_cpu() {
+    const char * env = std::getenv("PAKET_BENCH_CPU");
+    if (env == nullptr)
+        return;
+#   ifdef BENCH_PERF_EVENTS
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(std::atoi(env), &set);
+        if (sched_setaffinity(0, sizeof(set), &set) != 0)
+            std::cerr << "failed to pin benchmark to CPU " << env << std::endl;
+#   endif
+}
+
+struct result {
+    std::string name;
+    std::uint64_t iterations;
+    double ns_per_op;
+    double median_ns_per_op;
+    double bytes_per_second;
+    // per operation, negative if counter is not available
+    double events[counters::count];
+};
+
+/**
+ * Runs each benchmark in batches until it takes at least the minimal time
+ * (PAKET_BENCH_MIN_TIME milliseconds, 200 by default), then reports the
+ * best and the median of several batches.
+ */
+class suite {
+    typedef std::chrono::steady_clock clock;
+
+    std::string suite_name;
+    std::vector<result> results;
+    counters events;
+    double min_time;
+    static constexpr int samples = 5;
+
+public:
+    explicit suite(std::string name) : suite_name(std::move(name)) {
+        const char * env = std::getenv("PAKET_BENCH_MIN_TIME");
+        min_time = (env ? std::atof(env) : 200.0) * 1e6;
+    }
+
+    /**
+     * Measures the operation.
+     *
+     * \param name name of the benchmark
+     * \param items count of operations performed by one call of fun
+     * \param bytes count of encoded bytes processed by one call of fun
+     */
+    template <typename F>
+    void run(const std::string & name, std::size_t items, std::size_t bytes, F fun) {
+        std::uint64_t batch = 1;
+        // warm up and find the batch size that takes at least 1/samples of minimal time
+        for (;;) {
+            auto start = clock::now();
+            for (std::uint64_t i = 0; i < batch; ++i)
+                fun();
+            double elapsed = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+            if (elapsed * samples >= min_time || batch >= (std::uint64_t(1) << 40))
+                break;
+            batch *= elapsed * samples * 2 < min_time ? 10 : 2;
+        }
+        std::vector<double> times;
+        std::uint64_t totals[counters::count] = {};
+        for (int s = 0; s < samples; ++s) {
+            events.start();
+            auto start = clock::now();
+            for (std::uint64_t i = 0; i < batch; ++i)
+                fun();
+            times.push_back(std::chrono::duration<double, std::nano>(clock::now() - start).count());
+            std::uint64_t values[counters::count];
+            events.stop(values);
+            for (int k = 0; k < counters::count; ++k)
+                totals[k] += values[k];
+        }
+        std::sort(times.begin(), times.end());
+        double ops = double(batch) * double(items);
+        result r;
+        r.name = name;
+        r.iterations = batch * samples;
+        r.ns_per_op = times.front() / ops;
+        r.median_ns_per_op = times[samples / 2] / ops;
+        r.bytes_per_second = double(bytes) * double(batch) / (times.front() * 1e-9);
+        for (int k = 0; k < counters::count; ++k)
+            r.events[k] = events.available(k) ? double(totals[k]) / (ops * samples) : -1.0;
+        std::cerr << suite_name << '/' << name << ": " << r.ns_per_op << " ns/op, "
+            << r.bytes_per_second / (1024.0 * 1024.0) << " MiB/s" << std::endl;
+        results.push_back(std::move(r));
+    }
+
+    void write_json(std::ostream & out) const {
+        char buffer[64];
+        out << "{\"suite\":\"" << suite_name << "\",\"results\":[";
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            const result & r = results[i];
+            if (i != 0)
+                out << ',';
+            out << "\n  {\"name\":\"" << r.name << "\",\"iterations\":" << r.iterations;
+            std::snprintf(buffer, sizeof(buffer), "%.3f", r.ns_per_op);
+            out << ",\"ns_per_op\":" << buffer;
+            std::snprintf(buffer, sizeof(buffer), "%.3f", r.median_ns_per_op);
+            out << ",\"median_ns_per_op\":" << buffer;
+            std::snprintf(buffer, sizeof(buffer), "%.0f", r.bytes_per_second);
+            out << ",\"bytes_per_second\":" << buffer;
+            for (int k = 0; k < counters::count; ++k) {
+                if (r.events[k] < 0)
+                    continue;
+                std::snprintf(buffer, sizeof(buffer), "%.4f", r.events[k]);
+                out << ",\"" << counters::names[k] << "_per_op\":" << buffer;
+            }
+            out << '}';
+        }
+        out << "\n]}" << std::endl;
+    }
+};
+
+/**
+ * Values that resemble Minecraft traffic: mostly ids and small lengths,
+ * sometimes medium sizes and rarely full width values.
+ */
+template <typename T>
+std::vector<T> realistic_values(std::size_t count, std::uint32_t seed = 42) {
+    std::mt19937_64 random(seed);
+    std::vector<T> values(count);
+    for (auto & value : values) {
+        std::uint64_t r = random();
+        unsigned kind = r % 100;
+        r >>= 8;
+        if (kind < 70)
+            value = static_cast<T>(r % 128);
+        else if (kind < 95)
+            value = static_cast<T>(r % 16384);
+        else if (kind < 98)
+            value = static_cast<T>(r);
+        else
+            value = static_cast<T>(-static_cast<T>(r % 1000) - 1);
+    }
+    return values;
+}
+
+inline std::string random_text(std::size_t length, std::uint32_t seed = 7) {
+    std::mt19937 random(seed);
+    std::string text(length, ' ');
+    for (auto & c : text)
+        c = static_cast<char>('a' + random() % 26);
+    return text;
+}
+
+}
+
+#define benchmark \
+        void benchmark_function(::bench::suite & suite)
+
+void benchmark_function(::bench::suite & suite);
+
+int main(int argc, char * argv[]) {
+    std::string name = argv[0];
+    name = name.substr(name.find_last_of("/\\") + 1);
+    name = name.substr(0, name.find('.'));
+    ::bench::pin_cpu();
+    ::bench::suite suite(name);
+    benchmark_function(suite);
+    if (argc > 1) {
+        std::ofstream out(argv[1]);
+        suite.write_json(out);
+    } else {
+        suite.write_json(std::cout);
+    }
+}
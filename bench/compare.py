@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+"""Runs paket benchmarks several times and compares them with the baseline.
+
+Each benchmark binary writes JSON with the best ns/op of its batches and,
+where perf_event_open is allowed, hardware counters per operation. This
+script runs every binary --runs times pinned to one CPU, takes the median
+of the runs and reports a regression when the median is slower than the
+baseline median by more than --threshold and by more than the noise of
+both measurements (3 robust standard deviations estimated from MAD).
+
+    compare.py --build-dir build/bench              compare with bench/baseline.json
+    compare.py --build-dir build/bench --update     store new baseline
+"""
+
+import argparse
+import json
+import os
+import platform
+import statistics
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+METRICS = ['ns_per_op', 'instructions_per_op', 'branch_misses_per_op', 'cache_misses_per_op']
+
+
+def bench_names():
+    names = []
+    with open(os.path.join(HERE, 'meson.build')) as f:
+        inside = False
+        for line in f:
+            if line.startswith('bench_names = ['):
+                inside = True
+            elif inside and line.startswith(']'):
+                break
+            elif inside:
+                names.append(line.strip().strip(',').strip("'"))
+    return names
+
+
+def run_once(binary, cpu, min_time):
+    env = dict(os.environ)
+    env['PAKET_BENCH_MIN_TIME'] = str(min_time)
+    if cpu is not None:
+        env['PAKET_BENCH_CPU'] = str(cpu)
+    with tempfile.NamedTemporaryFile(suffix='.json', delete=False) as out:
+        path = out.name
+    try:
+        subprocess.run([binary, path], env=env, check=True, stderr=subprocess.DEVNULL)
+        with open(path) as f:
+            return json.load(f)
+    finally:
+        os.unlink(path)
+
+
+def collect(build_dir, names, runs, cpu, min_time):
+    samples = {}
+    for name in names:
+        binary = os.path.join(build_dir, name + '.bench')
+        if not os.path.exists(binary):
+            print('skipping %s: %s not found' % (name, binary), file=sys.stderr)
+            continue
+        for run in range(runs):
+            print('running %s (%d/%d)' % (name, run + 1, runs), file=sys.stderr)
+            report = run_once(binary, cpu, min_time)
+            for result in report['results']:
+                entry = samples.setdefault(report['suite'] + '/' + result['name'], {})
+                for metric in METRICS:
+                    if metric in result:
+                        entry.setdefault(metric, []).append(result[metric])
+    return samples
+
+
+def spread(values):
+    """Robust standard deviation estimated from median absolute deviation."""
+    if len(values) < 2:
+        return 0.0
+    center = statistics.median(values)
+    return 1.4826 * statistics.median(abs(v - center) for v in values)
+
+
+def compare(baseline, current, threshold, counter_threshold):
+    regressions = []
+    rows = []
+    for key in sorted(current):
+        if key not in baseline:
+            rows.append((key, 'ns_per_op', None, statistics.median(current[key]['ns_per_op']), 'new'))
+            continue
+        for metric in METRICS:
+            old = baseline[key].get(metric)
+            new = current[key].get(metric)
+            if not old or not new:
+                continue
+            old_median = statistics.median(old)
+            new_median = statistics.median(new)
+            limit = threshold if metric == 'ns_per_op' else counter_threshold
+            noise = 3 * max(spread(old), spread(new))
+            delta = new_median - old_median
+            status = ''
+            if old_median > 0 and abs(delta) > limit * old_median and abs(delta) > noise:
+                status = 'SLOWER' if delta > 0 else 'faster'
+                if delta > 0:
+                    regressions.append(key + ' ' + metric)
+            rows.append((key, metric, old_median, new_median, status))
+    return rows, regressions
+
+
+def print_rows(rows):
+    print('%-44s %-22s %12s %12s %8s' % ('benchmark', 'metric', 'baseline', 'current', 'change'))
+    for key, metric, old, new, status in rows:
+        if old is None:
+            print('%-44s %-22s %12s %12.3f %8s' % (key, metric, '-', new, status))
+            continue
+        change = (new - old) / old * 100 if old else 0.0
+        print('%-44s %-22s %12.3f %12.3f %+7.1f%% %s' % (key, metric, old, new, change, status))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--build-dir', default=os.path.join('build', 'bench'),
+                        help='directory with *.bench executables')
+    parser.add_argument('--baseline', default=os.path.join(HERE, 'baseline.json'))
+    parser.add_argument('--bench', action='append', help='benchmark to run, all by default')
+    parser.add_argument('--runs', type=int, default=5, help='runs of each benchmark binary')
+    parser.add_argument('--cpu', type=int, default=None, help='CPU to pin benchmarks to')
+    parser.add_argument('--min-time', type=float, default=100, help='minimal time of one measurement in ms')
+    parser.add_argument('--threshold', type=float, default=0.05, help='allowed relative slowdown of ns/op')
+    parser.add_argument('--counter-threshold', type=float, default=0.02,
+                        help='allowed relative growth of hardware counters')
+    parser.add_argument('--update', action='store_true', help='write results as the new baseline')
+    parser.add_argument('--report', help='also write current results to this JSON file')
+    args = parser.parse_args()
+
+    cpu = args.cpu
+    if cpu is None and hasattr(os, 'sched_getaffinity'):
+        cpu = max(os.sched_getaffinity(0))
+    current = collect(args.build_dir, args.bench or bench_names(), args.runs, cpu, args.min_time)
+    document = {
+        'machine': platform.machine(),
+        'processor': platform.processor(),
+        'system': platform.system(),
+        'runs': args.runs,
+        'min_time_ms': args.min_time,
+        'benchmarks': current,
+    }
+    if args.report:
+        with open(args.report, 'w') as f:
+            json.dump(document, f, indent=1, sort_keys=True)
+    if args.update:
+        with open(args.baseline, 'w') as f:
+            json.dump(document, f, indent=1, sort_keys=True)
+            f.write('\n')
+        print('baseline written to %s' % args.baseline)
+        return 0
+    if not os.path.exists(args.baseline):
+        print('no baseline at %s, run with --update first' % args.baseline, file=sys.stderr)
+        return 2
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+    if baseline.get('machine') != document['machine']:
+        print('warning: baseline was recorded on %s' % baseline.get('machine'), file=sys.stderr)
+    rows, regressions = compare(baseline['benchmarks'], current, args.threshold, args.counter_threshold)
+    print_rows(rows)
+    if regressions:
+        print('\n%d regression(s):' % len(regressions))
+        for each in regressions:
+            print('  ' + each)
+        return 1
+    print('\nno regressions')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
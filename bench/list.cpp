@@ -0,0 +1,78 @@
+#include <paket.hpp>
+
+#include "bench.hpp"
+
+using namespace handtruth::pakets;
+
+template <typename list_t>
+void bench_list(::bench::suite & suite, const std::string & name, const list_t & list) {
+	std::vector<byte_t> bytes(list.size());
+	list.write(bytes.data(), bytes.size());
+	std::size_t count = list.value.size();
+
+	list_t decoded;
+	suite.run("read_" + name, count, bytes.size(), [&]() {
+		::bench::keep(decoded.read(bytes.data(), bytes.size()));
+	});
+	suite.run("write_" + name, count, bytes.size(), [&]() {
+		::bench::keep(list.write(bytes.data(), bytes.size()));
+	});
+	suite.run("size_" + name, count, bytes.size(), [&]() {
+		::bench::keep(list.size());
+	});
+	suite.run("skip_" + name, count, bytes.size(), [&]() {
+		::bench::keep(list_t::skip(bytes.data(), bytes.size()));
+	});
+}
+
+template <unsigned bits, bit_packing packing>
+void bench_packed(::bench::suite & suite, const std::string & name) {
+	fields::packed_bits<bits, 4096, packing> section;
+	std::vector<std::int32_t> values = ::bench::realistic_values<std::int32_t>(4096);
+	for (std::size_t i = 0; i < 4096; ++i)
+		section.value[i] = static_cast<std::uint16_t>(values[i] & ((1 << bits) - 1));
+	std::vector<byte_t> bytes(section.size());
+	section.write(bytes.data(), bytes.size());
+
+	decltype(section) decoded;
+	suite.run("read_" + name, 4096, bytes.size(), [&]() {
+		::bench::keep(decoded.read(bytes.data(), bytes.size()));
+	});
+	suite.run("write_" + name, 4096, bytes.size(), [&]() {
+		::bench::keep(section.write(bytes.data(), bytes.size()));
+	});
+}
+
+benchmark {
+	fields::list<std::int32_t> varints;
+	for (std::int32_t value : ::bench::realistic_values<std::int32_t>(4096))
+		varints.value.emplace_back(value);
+	bench_list(suite, "list_varint", varints);
+
+	fields::list<std::int64_t> varlongs;
+	for (std::int64_t value : ::bench::realistic_values<std::int64_t>(4096))
+		varlongs.value.emplace_back(value);
+	bench_list(suite, "list_varlong", varlongs);
+
+	// block states and heightmaps are long arrays of packed values
+	fields::list<fields::int64> longs;
+	for (std::int64_t value : ::bench::realistic_values<std::int64_t>(4096))
+		longs.value.emplace_back(value);
+	bench_list(suite, "list_int64", longs);
+
+	fields::list<std::uint16_t> shorts;
+	for (std::int32_t value : ::bench::realistic_values<std::int32_t>(4096))
+		shorts.value.emplace_back(static_cast<std::uint16_t>(value));
+	bench_list(suite, "list_uint16", shorts);
+
+	// chunk section of 16x16x16 block states
+	bench_packed<4, bit_packing::padded>(suite, "packed_4");
+	bench_packed<5, bit_packing::padded>(suite, "packed_5");
+	bench_packed<15, bit_packing::padded>(suite, "packed_15");
+	bench_packed<5, bit_packing::spanning>(suite, "packed_5_spanning");
+
+	fields::list<std::string> strings;
+	for (std::uint32_t i = 0; i < 256; ++i)
+		strings.value.emplace_back(::bench::random_text(4 + i % 28, i));
+	bench_list(suite, "list_string", strings);
+}
@@ -0,0 +1,75 @@
+#include <paket_nbt.hpp>
+
+#include "bench.hpp"
+
+using namespace handtruth::pakets;
+
+// window items of a player inventory, every slot carries item NBT
+struct window_items_paket : paket<0x14, fields::byte, fields::varint, fields::list<fields::network_nbt>> {};
+
+static void put(std::vector<byte_t> & bytes, std::uint64_t value, int width) {
+	for (int i = width - 1; i >= 0; --i)
+		bytes.push_back(static_cast<byte_t>(value >> (8 * i)));
+}
+
+static void put_name(std::vector<byte_t> & bytes, nbt_tag type, const std::string & name) {
+	put(bytes, static_cast<std::uint64_t>(type), 1);
+	put(bytes, name.size(), 2);
+	bytes.insert(bytes.end(), name.begin(), name.end());
+}
+
+static std::vector<byte_t> item(std::uint32_t seed) {
+	std::vector<byte_t> bytes;
+	put(bytes, static_cast<std::uint64_t>(nbt_tag::compound), 1);
+	put_name(bytes, nbt_tag::int32, "Damage");
+	put(bytes, seed % 1561, 4);
+	put_name(bytes, nbt_tag::list, "Enchantments");
+	put(bytes, static_cast<std::uint64_t>(nbt_tag::compound), 1);
+	put(bytes, seed % 4, 4);
+	for (std::uint32_t i = 0; i < seed % 4; ++i) {
+		std::string id = "minecraft:" + ::bench::random_text(8, seed + i);
+		put_name(bytes, nbt_tag::string, "id");
+		put(bytes, id.size(), 2);
+		bytes.insert(bytes.end(), id.begin(), id.end());
+		put_name(bytes, nbt_tag::int16, "lvl");
+		put(bytes, 1 + i, 2);
+		put(bytes, 0, 1);
+	}
+	put_name(bytes, nbt_tag::compound, "display");
+	std::string lore = ::bench::random_text(40, seed);
+	put_name(bytes, nbt_tag::string, "Name");
+	put(bytes, lore.size(), 2);
+	bytes.insert(bytes.end(), lore.begin(), lore.end());
+	put(bytes, 0, 1);
+	put(bytes, 0, 1);
+	return bytes;
+}
+
+benchmark {
+	std::vector<std::vector<byte_t>> items;
+	window_items_paket window;
+	window.field<0>() = 0;
+	window.field<1>() = 1;
+	for (std::uint32_t i = 0; i < 46; ++i) {
+		items.push_back(item(i));
+		nbt_view view;
+		try_read_nbt(view, items.back().data(), items.back().size(), false);
+		window.field<2>().emplace_back(view);
+	}
+	std::vector<byte_t> bytes(window.size() + 10);
+	int size = window.write(bytes.data(), bytes.size());
+
+	window_items_paket decoded;
+	suite.run("read_window_items", 46, size, [&]() {
+		::bench::keep(decoded.read(bytes.data(), size));
+	});
+	suite.run("lookup_window_items", 46, size, [&]() {
+		std::int32_t damage = 0;
+		for (const fields::network_nbt & slot : decoded.field<2>())
+			damage += slot.value["Damage"].as_int32() + static_cast<std::int32_t>(slot.value["Enchantments"].size());
+		::bench::keep(damage);
+	});
+	suite.run("write_window_items", 46, size, [&]() {
+		::bench::keep(decoded.write(bytes.data(), bytes.size()));
+	});
+}
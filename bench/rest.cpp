@@ -0,0 +1,26 @@
+#include <paket.hpp>
+
+#include "bench.hpp"
+
+using namespace handtruth::pakets;
+
+benchmark {
+	for (std::size_t length : { 64, 4096, 65536 }) {
+		fields::rest field;
+		field.value.assign(length, 0x5a);
+		std::vector<byte_t> bytes(length);
+		std::string suffix = "_" + std::to_string(length);
+
+		fields::rest decoded;
+		suite.run("read_rest" + suffix, 1, length, [&]() {
+			::bench::keep(decoded.read(bytes.data(), bytes.size()));
+		});
+		suite.run("write_rest" + suffix, 1, length, [&]() {
+			::bench::keep(field.write(bytes.data(), bytes.size()));
+		});
+		fields::bytes_view view;
+		suite.run("read_bytes_view" + suffix, 1, length, [&]() {
+			::bench::keep(view.read(bytes.data(), bytes.size()));
+		});
+	}
+}
@@ -0,0 +1,96 @@
+#include <paket.hpp>
+
+#include "bench.hpp"
+
+using namespace handtruth::pakets;
+
+// modeled on packets of the Minecraft protocol
+
+struct handshake_paket : paket<0x00, fields::varint, fields::string, fields::uint16, fields::varint> {};
+struct keep_alive_paket : paket<0x21, fields::int64> {};
+struct movement_paket : paket<0x12, fields::int64, fields::int64, fields::int64, fields::boolean, fields::byte> {};
+struct position_paket : paket<0x11, fields::varint, fields::float64, fields::float64, fields::float64, fields::float32, fields::float32, fields::boolean> {};
+struct chat_paket : paket<0x0F, fields::string, fields::byte> {};
+struct chunk_paket : paket<0x22, fields::varint, fields::varint, fields::boolean, fields::varint, fields::rest> {};
+struct player_list_paket : paket<0x34, fields::varint, fields::list<std::string>, fields::list<std::int32_t>> {};
+
+template <typename paket_t>
+void bench_paket(::bench::suite & suite, const std::string & name, const paket_t & source) {
+	std::vector<byte_t> bytes(source.size() + 10);
+	int size = source.write(bytes.data(), bytes.size());
+
+	suite.run("write_" + name, 1, size, [&]() {
+		::bench::keep(source.write(bytes.data(), bytes.size()));
+	});
+	paket_t decoded;
+	suite.run("read_" + name, 1, size, [&]() {
+		::bench::keep(decoded.read(bytes.data(), size));
+	});
+	suite.run("validate_" + name, 1, size, [&]() {
+		::bench::keep(paket_t::validate(bytes.data(), size));
+	});
+	suite.run("round_trip_" + name, 1, size, [&]() {
+		int s = source.write(bytes.data(), bytes.size());
+		::bench::keep(decoded.read(bytes.data(), s));
+	});
+	if constexpr (paket_t::is_bounded()) {
+		std::array<byte_t, paket_t::max_frame_size()> buffer;
+		suite.run("write_unchecked_" + name, 1, size, [&]() {
+			::bench::keep(source.write_unchecked(buffer));
+		});
+		suite.run("read_unchecked_" + name, 1, size, [&]() {
+			::bench::keep(decoded.read_unchecked(buffer));
+		});
+	}
+}
+
+benchmark {
+	handshake_paket handshake;
+	handshake.field<0>() = 340;
+	handshake.field<1>() = "mc.example.org";
+	handshake.field<2>() = 25565;
+	handshake.field<3>() = 2;
+	bench_paket(suite, "handshake", handshake);
+
+	keep_alive_paket keep_alive;
+	keep_alive.field<0>() = 1234567890123;
+	bench_paket(suite, "keep_alive", keep_alive);
+
+	movement_paket movement;
+	movement.field<0>() = 0x0000012345678000ll;
+	movement.field<1>() = -4096;
+	movement.field<2>() = 0x00000fedcba98000ll;
+	movement.field<3>() = true;
+	movement.field<4>() = 0x7f;
+	bench_paket(suite, "movement", movement);
+
+	position_paket position;
+	position.field<0>() = 4021;
+	position.field<1>() = 128.5;
+	position.field<2>() = 64.0;
+	position.field<3>() = -1031.25;
+	position.field<4>() = 90.0f;
+	position.field<5>() = -12.5f;
+	position.field<6>() = true;
+	bench_paket(suite, "position", position);
+
+	chat_paket chat;
+	chat.field<0>() = "{\"text\":\"" + ::bench::random_text(120) + "\",\"color\":\"yellow\"}";
+	bench_paket(suite, "chat", chat);
+
+	chunk_paket chunk;
+	chunk.field<0>() = -12;
+	chunk.field<1>() = 31;
+	chunk.field<2>() = true;
+	chunk.field<3>() = 0xffff;
+	chunk.field<4>().assign(16384, 3);
+	bench_paket(suite, "chunk", chunk);
+
+	player_list_paket players;
+	players.field<0>() = 0;
+	for (std::uint32_t i = 0; i < 40; ++i) {
+		players.field<1>().emplace_back(::bench::random_text(3 + i % 13, i));
+		players.field<2>().emplace_back(static_cast<std::int32_t>(i * 37));
+	}
+	bench_paket(suite, "player_list", players);
+}
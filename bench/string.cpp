@@ -0,0 +1,29 @@
+#include <paket.hpp>
+
+#include "bench.hpp"
+
+using namespace handtruth::pakets;
+
+benchmark {
+	for (std::size_t length : { 8, 64, 1024, 32767 }) {
+		fields::string field(::bench::random_text(length));
+		std::vector<byte_t> bytes(field.size());
+		field.write(bytes.data(), bytes.size());
+		std::string suffix = "_" + std::to_string(length);
+
+		fields::string decoded;
+		suite.run("read_string" + suffix, 1, bytes.size(), [&]() {
+			::bench::keep(decoded.read(bytes.data(), bytes.size()));
+		});
+		fields::string_view view;
+		suite.run("read_string_view" + suffix, 1, bytes.size(), [&]() {
+			::bench::keep(view.read(bytes.data(), bytes.size()));
+		});
+		suite.run("write_string" + suffix, 1, bytes.size(), [&]() {
+			::bench::keep(field.write(bytes.data(), bytes.size()));
+		});
+		suite.run("skip_string" + suffix, 1, bytes.size(), [&]() {
+			::bench::keep(fields::string::skip(bytes.data(), bytes.size()));
+		});
+	}
+}
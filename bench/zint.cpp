@@ -0,0 +1,45 @@
+#include <paket.hpp>
+
+#include "bench.hpp"
+
+using namespace handtruth::pakets;
+
+template <typename numeric>
+void bench_zint(::bench::suite & suite, const std::string & name) {
+	constexpr std::size_t count = 4096;
+	auto values = ::bench::realistic_values<numeric>(count);
+	std::vector<byte_t> bytes(count * max_zint_size<numeric>());
+	std::size_t size = 0;
+	for (numeric value : values)
+		size += write_zint(value, bytes.data() + size, bytes.size() - size);
+
+	suite.run("read_" + name, count, size, [&]() {
+		const byte_t * data = bytes.data();
+		std::size_t offset = 0;
+		numeric value;
+		for (std::size_t i = 0; i < count; ++i) {
+			offset += read_zint(value, data + offset, size - offset);
+			::bench::keep(value);
+		}
+	});
+	suite.run("write_" + name, count, size, [&]() {
+		byte_t * data = bytes.data();
+		std::size_t offset = 0;
+		for (numeric value : values)
+			offset += write_zint(value, data + offset, bytes.size() - offset);
+		::bench::keep(offset);
+	});
+	suite.run("read_" + name + "_bulk", count, size, [&]() {
+		read_zint_bulk(values.data(), count, bytes.data(), size);
+		::bench::keep(values);
+	});
+	suite.run("write_" + name + "_bulk", count, size, [&]() {
+		::bench::keep(write_zint_bulk(values.data(), count, bytes.data(), bytes.size()));
+	});
+}
+
+benchmark {
+	bench_zint<std::int32_t>(suite, "zint32");
+	bench_zint<std::int64_t>(suite, "zint64");
+	bench_zint<std::uint32_t>(suite, "uzint32");
+}
@@ -3,13 +3,17 @@
 
 #include <cinttypes>
 #include <tuple>
+#include <utility>
 #include <string>
+#include <string_view>
 #include <stdexcept>
 #include <vector>
 #include <initializer_list>
 #include <limits>
 #include <array>
 #include <type_traits>
+#include <cstring>
+#include <memory_resource>
 
 #if defined(__BYTE_ORDER) && __BYTE_ORDER == __BIG_ENDIAN || \
     defined(__BIG_ENDIAN__) || \
@@ -29,6 +33,10 @@
 //#	error "unknown architecture"
 #endif
 
+#if !defined(__cpp_exceptions) && !defined(__EXCEPTIONS)
+#	define PAKET_NO_EXCEPTIONS
+#endif
+
 namespace handtruth {
 
 namespace pakets {
@@ -46,6 +54,195 @@ public:
 	paket_error(const std::string & message) : std::runtime_error(message) {}
 };
 
+/**
+ * \brief Reason why data can't be decoded.
+ * 
+ * Codes are negative, so the try_read() family returns them instead of the
+ * count of read bytes.
+ */
+enum class paket_errc : int {
+	ok = 0,
+	/// there is not enough data yet
+	incomplete = -1,
+	/// varnum or zint is longer than its type allows
+	varnum_too_big = -2,
+	/// length of string or list is lower than 0
+	negative_length = -3,
+	/// frame contains other paket id
+	wrong_id = -4,
+	/// paket fields do not take exactly the whole frame
+	wrong_size = -5,
+	/// frame length is lower than 0 or too small for paket id
+	wrong_frame = -6,
+	/// decoded values need more memory than memory_budget allows
+	budget_exceeded = -7,
+	/// NBT has unknown tag type or is nested too deep
+	wrong_nbt = -8,
+};
+
+/**
+ * \return short description of the error
+ */
+const char * describe(paket_errc error) noexcept;
+
+/**
+ * \brief Outcome of try_read() and other decoding functions that do not throw.
+ */
+struct read_result {
+	/// paket_errc::ok on success
+	paket_errc error = paket_errc::ok;
+	/// count of read bytes on success, otherwise offset of the malformed data
+	std::size_t offset = 0;
+
+	constexpr bool ok() const noexcept {
+		return error == paket_errc::ok;
+	}
+	explicit constexpr operator bool() const noexcept {
+		return ok();
+	}
+};
+
+/**
+ * Layout of entries in the longs of fields::packed_bits. Entries are
+ * stored from the lowest bits of each long.
+ */
+enum class bit_packing : std::uint8_t {
+	/// entry never crosses longs, high bits of a long may be unused (Minecraft 1.16+)
+	padded,
+	/// entries follow each other and may continue in the next long
+	spanning,
+};
+
+namespace detail {
+
+/**
+ * Throws paket_error or, if the library is built without exceptions,
+ * prints the message and aborts.
+ */
+[[noreturn]] void raise(const std::string & message);
+[[noreturn]] void raise(paket_errc error);
+[[noreturn]] void raise(paket_errc error, std::size_t offset);
+
+/**
+ * Converts error code returned by try_read() of a field to the result of
+ * read(). Only paket_errc::incomplete is returned as -1.
+ */
+inline int checked(int size) {
+	if (size < -1)
+		raise(static_cast<paket_errc>(size));
+	return size;
+}
+
+template <std::size_t n>
+struct unsigned_of_size;
+template <> struct unsigned_of_size<1> { typedef std::uint8_t type; };
+template <> struct unsigned_of_size<2> { typedef std::uint16_t type; };
+template <> struct unsigned_of_size<4> { typedef std::uint32_t type; };
+template <> struct unsigned_of_size<8> { typedef std::uint64_t type; };
+
+constexpr std::uint8_t byte_swap(std::uint8_t value) noexcept {
+	return value;
+}
+constexpr std::uint16_t byte_swap(std::uint16_t value) noexcept {
+#	ifdef __GNUC__
+		return __builtin_bswap16(value);
+#	else
+		return static_cast<std::uint16_t>((value >> 8) | (value << 8));
+#	endif
+}
+constexpr std::uint32_t byte_swap(std::uint32_t value) noexcept {
+#	ifdef __GNUC__
+		return __builtin_bswap32(value);
+#	else
+		return (value >> 24) | ((value >> 8) & 0xff00u) | ((value << 8) & 0xff0000u) | (value << 24);
+#	endif
+}
+constexpr std::uint64_t byte_swap(std::uint64_t value) noexcept {
+#	ifdef __GNUC__
+		return __builtin_bswap64(value);
+#	else
+		return (std::uint64_t(byte_swap(static_cast<std::uint32_t>(value))) << 32) | byte_swap(static_cast<std::uint32_t>(value >> 32));
+#	endif
+}
+
+/**
+ * Loads big endian value from possibly unaligned bytes.
+ */
+template <typename T>
+inline T load_big_endian(const byte_t bytes[]) noexcept {
+	typedef typename unsigned_of_size<sizeof(T)>::type raw_t;
+	raw_t raw;
+	std::memcpy(&raw, bytes, sizeof(raw));
+#	ifndef PAKET_BIG_ENDIAN
+		raw = byte_swap(raw);
+#	endif
+	T value;
+	std::memcpy(&value, &raw, sizeof(value));
+	return value;
+}
+
+/**
+ * Stores value to possibly unaligned bytes in big endian order.
+ */
+template <typename T>
+inline void store_big_endian(byte_t bytes[], T value) noexcept {
+	typedef typename unsigned_of_size<sizeof(T)>::type raw_t;
+	raw_t raw;
+	std::memcpy(&raw, &value, sizeof(raw));
+#	ifndef PAKET_BIG_ENDIAN
+		raw = byte_swap(raw);
+#	endif
+	std::memcpy(bytes, &raw, sizeof(raw));
+}
+
+/**
+ * Copies count values of width bytes each reversing bytes of every value,
+ * so host order values become big endian and vice versa. Uses SSSE3 or
+ * AVX2 shuffles when the processor supports them.
+ */
+void swap_bytes(byte_t destination[], const byte_t source[], std::size_t count, std::size_t width) noexcept;
+
+/**
+ * Copies count big endian values of width bytes to host order values.
+ */
+inline void copy_big_endian(byte_t destination[], const byte_t source[], std::size_t count, std::size_t width) noexcept {
+	if (count == 0)
+		return;
+#	ifdef PAKET_BIG_ENDIAN
+		std::memcpy(destination, source, count * width);
+#	else
+		if (width == 1)
+			std::memcpy(destination, source, count);
+		else
+			swap_bytes(destination, source, count, width);
+#	endif
+}
+
+/**
+ * \return count of longs that hold count entries of bits each
+ */
+constexpr std::size_t packed_words(std::size_t count, unsigned bits, bit_packing packing) noexcept {
+	if (packing == bit_packing::padded)
+		return (count + 64 / bits - 1) / (64 / bits);
+	return (count * bits + 63) / 64;
+}
+
+/**
+ * Unpacks count entries of bits each from packed_words() big endian longs.
+ * Uses AVX2 shifts and shuffles when the processor supports them.
+ */
+void unpack_bits(std::uint16_t destination[], std::size_t count, const byte_t source[], unsigned bits, bit_packing packing) noexcept;
+void unpack_bits(std::uint32_t destination[], std::size_t count, const byte_t source[], unsigned bits, bit_packing packing) noexcept;
+
+/**
+ * Packs count entries into packed_words() big endian longs. Bits of the
+ * entries above bits are ignored, unused bits of the longs are zero.
+ */
+void pack_bits(byte_t destination[], const std::uint16_t source[], std::size_t count, unsigned bits, bit_packing packing) noexcept;
+void pack_bits(byte_t destination[], const std::uint32_t source[], std::size_t count, unsigned bits, bit_packing packing) noexcept;
+
+} // namespace detail
+
 template <typename numeric>
 constexpr std::size_t max_varnum_size() {
 	static_assert(std::is_integral_v<numeric>);
@@ -62,27 +259,196 @@ constexpr std::enable_if_t<std::is_signed_v<numeric>, std::size_t> max_zint_size
 	return (sizeof(numeric) * 8 + 1) / 7 + ((sizeof(numeric) * 8 + 1) % 7 > 0);
 }
 
+namespace detail {
+
+/**
+ * Decodes varnum from a block of at least 8 bytes at once. Implementation
+ * is selected at runtime from the features of the CPU.
+ * 
+ * \param value decoded payload bits of the varnum
+ * \param bytes block with at least 8 readable bytes
+ * \return size of varnum in bytes or 0 if it does not end within the block
+ */
+int read_varnum_block(std::uint64_t & value, const byte_t bytes[]) noexcept;
+
+/**
+ * Decodes all varnums that end within the first 8 bytes of the block.
+ * 
+ * \param values decoded payload bits of each varnum, up to 8 entries
+ * \param max_count maximum number of varnums to decode
+ * \param limit maximum size of one varnum in bytes
+ * \param bytes block with at least 8 readable bytes
+ * \param count number of decoded varnums
+ * \return size of decoded varnums in bytes
+ */
+std::size_t read_varnum_window(std::uint64_t values[], std::size_t max_count, std::size_t limit,
+								const byte_t bytes[], std::size_t & count) noexcept;
+
+template <typename T>
+constexpr auto & unwrap(T & value) noexcept {
+	if constexpr (std::is_arithmetic_v<T>)
+		return value;
+	else
+		return value.value;
+}
+
+template <typename T>
+using unwrapped_t = std::remove_cv_t<std::remove_reference_t<decltype(unwrap(std::declval<T &>()))>>;
+
+constexpr std::size_t bit_width(std::uint64_t value) noexcept {
+#	ifdef __GNUC__
+		return value == 0 ? 0 : 64 - __builtin_clzll(value);
+#	else
+		std::size_t n = 0;
+		for (; value != 0; value >>= 1)
+			++n;
+		return n;
+#	endif
+}
+
+/**
+ * Absolute value of the number. Negation is done in the unsigned type,
+ * so the minimum value of the signed type is fine too.
+ */
 template <typename numeric>
-int read_varnum(numeric & value, const byte_t bytes[], std::size_t length) {
+constexpr std::make_unsigned_t<numeric> magnitude(numeric value) noexcept {
+	typedef std::make_unsigned_t<numeric> unsigned_t;
+	unsigned_t uval = static_cast<unsigned_t>(value);
+	return value < 0 ? static_cast<unsigned_t>(0u - uval) : uval;
+}
+
+/**
+ * Size of varnum that carries the specified number of payload bits.
+ * Same as division by 7 rounded up for up to 70 bits.
+ */
+constexpr std::size_t varnum_size_of_bits(std::size_t bits) noexcept {
+	return (bits * 9 + 64) / 64;
+}
+
+/**
+ * Writes varnum lesser than 2^56 as one 8-byte store. Bytes after the
+ * varnum inside the block get overwritten with garbage.
+ * 
+ * \param value unsigned payload of varnum
+ * \param bytes block with at least 8 writable bytes
+ * \return size of written varnum
+ */
+inline std::size_t write_varnum_block(std::uint64_t value, byte_t bytes[]) noexcept {
+	std::size_t n = varnum_size_of_bits(bit_width(value | 1));
+	std::uint64_t word = value;
+	word = ((word & 0x00fffffff0000000ull) << 4) | (word & 0x000000000fffffffull);
+	word = ((word & 0x0fffc0000fffc000ull) << 2) | (word & 0x00003fff00003fffull);
+	word = ((word & 0x3f803f803f803f80ull) << 1) | (word & 0x007f007f007f007full);
+	word |= 0x8080808080808080ull & ((std::uint64_t(1) << (8 * (n - 1))) - 1);
+	for (std::size_t i = 0; i < 8; ++i, word >>= 8)
+		bytes[i] = static_cast<byte_t>(word);
+	return n;
+}
+
+template <typename T, typename = void>
+struct is_sink : std::false_type {};
+
+template <typename T>
+struct is_sink<T, std::void_t<decltype(std::declval<T &>().reserve(std::size_t()) + 0),
+							decltype(std::declval<T &>().commit(std::size_t()))>> : std::true_type {};
+
+template <typename sink_t, typename R = int>
+using enable_if_sink_t = std::enable_if_t<is_sink<sink_t>::value, R>;
+
+/**
+ * Reserves space for the field in the sink, writes the field there and
+ * commits written bytes.
+ * 
+ * \param size space to reserve, must be enough for the field
+ * \return count of written bytes or -1 if the sink has no space
+ */
+template <typename sink_t, typename field_t>
+int write_reserved(sink_t & sink, const field_t & field, std::size_t size) {
+	byte_t * bytes = sink.reserve(size);
+	if (bytes == nullptr)
+		return -1;
+	int s = field.write(bytes, size);
+	if (s < 0)
+		return -1;
+	sink.commit(static_cast<std::size_t>(s));
+	return s;
+}
+
+/**
+ * Finds the end of varnum without decoding it.
+ * 
+ * \param limit maximum size of varnum in bytes
+ * \return size of varnum, 0 if it is longer than limit or -1 if there is not enough data
+ */
+inline int skip_varnum(const byte_t bytes[], std::size_t length, std::size_t limit) noexcept {
+#	if defined(__GNUC__) && !defined(PAKET_BIG_ENDIAN)
+		if (length >= 8) {
+			std::uint64_t word;
+			std::memcpy(&word, bytes, 8);
+			std::uint64_t ends = ~word & 0x8080808080808080ull;
+			if (ends != 0) {
+				std::size_t n = static_cast<std::size_t>(__builtin_ctzll(ends)) / 8 + 1;
+				return n <= limit ? static_cast<int>(n) : 0;
+			}
+			if (limit <= 8)
+				return 0;
+		}
+#	endif
+	std::size_t n = length < limit ? length : limit;
+	for (std::size_t i = 0; i < n; ++i)
+		if ((bytes[i] & 0b10000000) == 0)
+			return static_cast<int>(i + 1);
+	return n == limit ? 0 : -1;
+}
+
+} // namespace detail
+
+/**
+ * Reads varnum without throwing exceptions.
+ * 
+ * \return count of read bytes, -1 if there is not enough data or
+ *         paket_errc::varnum_too_big
+ */
+template <typename numeric>
+int try_read_varnum(numeric & value, const byte_t bytes[], std::size_t length) noexcept {
+	if (length != 0 && (bytes[0] & 0b10000000) == 0) {
+		value = static_cast<numeric>(bytes[0]);
+		return 1;
+	}
+	if (length >= 8) {
+		std::uint64_t block;
+		int n = detail::read_varnum_block(block, bytes);
+		if (n != 0 && static_cast<std::size_t>(n) <= max_varnum_size<numeric>()) {
+			value = static_cast<numeric>(block);
+			return n;
+		}
+	}
 	std::size_t numRead = 0;
     byte_t read;
-	value = 0;
+    std::make_unsigned_t<numeric> uval = 0;
     do {
 		if (numRead == length)
 			return -1;
+        if (numRead == max_varnum_size<numeric>()) {
+            return static_cast<int>(paket_errc::varnum_too_big);
+        }
         read = bytes[numRead];
-        numeric tmp = (read & 0b01111111);
+        std::make_unsigned_t<numeric> tmp = (read & 0b01111111);
 
-		value |= (tmp << (7 * numRead));
+		// unsigned, so bits shifted out of the last byte are just dropped
+		uval |= (tmp << (7 * numRead));
 
         numRead++;
-        if (numRead > max_varnum_size<numeric>()) {
-            throw paket_error("varint is too big");
-        }
     } while ((read & 0b10000000) != 0);
+    value = static_cast<numeric>(uval);
     return numRead;
 }
 
+template <typename numeric>
+int read_varnum(numeric & value, const byte_t bytes[], std::size_t length) {
+	return detail::checked(try_read_varnum(value, bytes, length));
+}
+
 template <typename numeric>
 int write_varnum(numeric value, byte_t bytes[], std::size_t length) {
 	std::size_t numWrite = 0;
@@ -102,37 +468,244 @@ int write_varnum(numeric value, byte_t bytes[], std::size_t length) {
 	return numWrite;
 }
 
+/**
+ * Get size of encoded varnum without encoding it.
+ */
 template <typename numeric>
-std::enable_if_t<std::is_unsigned_v<numeric>, int> read_zint(numeric & value, const byte_t bytes[], std::size_t length) {
-	return read_varnum(value, bytes, length);
+constexpr std::size_t size_varnum(numeric value) noexcept {
+	std::make_unsigned_t<numeric> uval = value;
+	return detail::varnum_size_of_bits(detail::bit_width(uval | 1));
+}
+
+/**
+ * Get summary size of several encoded varnums. Each element of the array is
+ * either integer or field holding integer value.
+ */
+template <typename T>
+std::size_t size_varnum_bulk(const T values[], std::size_t count) noexcept {
+	typedef std::make_unsigned_t<detail::unwrapped_t<const T>> unsigned_t;
+	constexpr std::size_t bits = sizeof(unsigned_t) * 8;
+	std::size_t size = 0;
+	if constexpr (bits <= 32) {
+		// comparisons instead of bit scan, so the loop is vectorized
+		for (std::size_t i = 0; i < count; ++i) {
+			unsigned_t uval = detail::unwrap(values[i]);
+			std::uint32_t n = 1;
+			for (std::size_t shift = 7; shift < bits; shift += 7)
+				n += uval >= (unsigned_t(1) << shift);
+			size += n;
+		}
+	} else {
+		for (std::size_t i = 0; i < count; ++i)
+			size += size_varnum(detail::unwrap(values[i]));
+	}
+	return size;
 }
 
+/**
+ * Writes several varnums one after another.
+ * 
+ * \see size_varnum_bulk
+ * \return count of written bytes or -1 if buffer is too small
+ */
+template <typename T>
+int write_varnum_bulk(const T values[], std::size_t count, byte_t bytes[], std::size_t length) {
+	typedef std::make_unsigned_t<detail::unwrapped_t<const T>> unsigned_t;
+	std::size_t offset = 0;
+	for (std::size_t i = 0; i < count; ++i) {
+		unsigned_t uval = detail::unwrap(values[i]);
+		if (length - offset >= 8 && std::uint64_t(uval) < (std::uint64_t(1) << 56)) {
+			offset += detail::write_varnum_block(uval, bytes + offset);
+			continue;
+		}
+		int s = write_varnum(detail::unwrap(values[i]), bytes + offset, length - offset);
+		if (s < 0)
+			return -1;
+		offset += s;
+	}
+	return static_cast<int>(offset);
+}
+
+/**
+ * Writes varnum that occupies exactly the specified count of bytes. Such
+ * non-minimal varnum is decoded the same way as the shortest one.
+ * 
+ * \param width count of bytes for varnum, should not exceed max_varnum_size()
+ * \return width or -1 if value can't be encoded in width bytes
+ */
 template <typename numeric>
-std::enable_if_t<std::is_signed_v<numeric>, int> read_zint(numeric & value, const byte_t bytes[], std::size_t length) {
+int write_varnum_padded(numeric value, byte_t bytes[], std::size_t width) {
+	if (width == 0 || size_varnum(value) > width)
+		return -1;
+	std::make_unsigned_t<numeric> uval = value;
+	for (std::size_t i = 0; i < width; ++i) {
+		byte_t temp = static_cast<byte_t>(uval & 0b01111111);
+		uval >>= 7;
+		if (i + 1 != width)
+			temp |= 0b10000000;
+		bytes[i] = temp;
+	}
+	return static_cast<int>(width);
+}
+
+/**
+ * Finds the end of varnum without decoding it.
+ * 
+ * \return size of varnum, -1 if there is not enough data or
+ *         paket_errc::varnum_too_big
+ */
+template <typename numeric>
+int skip_varnum(const byte_t bytes[], std::size_t length) noexcept {
+	int s = detail::skip_varnum(bytes, length, max_varnum_size<numeric>());
+	return s == 0 ? static_cast<int>(paket_errc::varnum_too_big) : s;
+}
+
+/**
+ * Reads zint without throwing exceptions.
+ * 
+ * \see try_read_varnum
+ */
+template <typename numeric>
+std::enable_if_t<std::is_unsigned_v<numeric>, int> try_read_zint(numeric & value, const byte_t bytes[], std::size_t length) noexcept {
+	return try_read_varnum(value, bytes, length);
+}
+
+template <typename numeric>
+std::enable_if_t<std::is_signed_v<numeric>, int> try_read_zint(numeric & value, const byte_t bytes[], std::size_t length) noexcept {
 	if (length == 0)
 		return -1;
+	typedef std::make_unsigned_t<numeric> unsigned_t;
 	std::size_t numRead = 1;
     byte_t read = bytes[0];
 	bool sign = read & 1;
-	value = (read >> 1) & 0b00111111;
+	unsigned_t result = (read >> 1) & 0b00111111;
     while ((read & 0b10000000) != 0) {
 		if (numRead == length)
 			return -1;
         read = bytes[numRead];
-        numeric tmp = (read & 0b01111111);
+        unsigned_t tmp = (read & 0b01111111);
 
-		value |= (tmp << (7 * (numRead - 1) + 6));
+		result |= (tmp << (7 * (numRead - 1) + 6));
 
         numRead++;
         if (numRead > max_zint_size<numeric>()) {
-            throw paket_error("szint is too big");
+            return static_cast<int>(paket_errc::varnum_too_big);
         }
     }
 	if (sign)
-		value = -value;
+		result = 0u - result;
+	value = static_cast<numeric>(result);
     return numRead;
 }
 
+template <typename numeric>
+int read_zint(numeric & value, const byte_t bytes[], std::size_t length) {
+	return detail::checked(try_read_zint(value, bytes, length));
+}
+
+namespace detail {
+
+/**
+ * Writes varnum without checking the size of the buffer. There should be
+ * at least max_varnum_size<numeric>() bytes.
+ * 
+ * \return count of written bytes
+ */
+template <typename numeric>
+inline std::size_t write_varnum_unchecked(numeric value, byte_t bytes[]) noexcept {
+	std::make_unsigned_t<numeric> uval = value;
+	std::size_t n = 0;
+	while (uval >= 0b10000000) {
+		bytes[n++] = static_cast<byte_t>(uval | 0b10000000);
+		uval >>= 7;
+	}
+	bytes[n++] = static_cast<byte_t>(uval);
+	return n;
+}
+
+/**
+ * Reads varnum without checking the size of the buffer. There should be
+ * at least max_varnum_size<numeric>() bytes.
+ * 
+ * \return count of read bytes or paket_errc::varnum_too_big
+ */
+template <typename numeric>
+inline int read_varnum_unchecked(numeric & value, const byte_t bytes[]) noexcept {
+	std::uint64_t result = 0;
+	for (std::size_t i = 0; i < max_varnum_size<numeric>(); ++i) {
+		result |= std::uint64_t(bytes[i] & 0b01111111) << (7 * i);
+		if ((bytes[i] & 0b10000000) == 0) {
+			value = static_cast<numeric>(result);
+			return static_cast<int>(i + 1);
+		}
+	}
+	return static_cast<int>(paket_errc::varnum_too_big);
+}
+
+/**
+ * Writes zint without checking the size of the buffer. There should be
+ * at least max_zint_size<numeric>() bytes.
+ * 
+ * \return count of written bytes
+ */
+template <typename numeric>
+inline std::size_t write_zint_unchecked(numeric value, byte_t bytes[]) noexcept {
+	if constexpr (std::is_unsigned_v<numeric>) {
+		return write_varnum_unchecked(value, bytes);
+	} else {
+		byte_t sign = value < 0;
+		std::make_unsigned_t<numeric> uval = magnitude(value);
+		byte_t first = static_cast<byte_t>((uval & 0b00111111) << 1) | sign;
+		uval >>= 6;
+		if (uval == 0) {
+			bytes[0] = first;
+			return 1;
+		}
+		bytes[0] = first | 0b10000000;
+		return 1 + write_varnum_unchecked(uval, bytes + 1);
+	}
+}
+
+/**
+ * Reads zint without checking the size of the buffer. There should be
+ * at least max_zint_size<numeric>() bytes.
+ * 
+ * \return count of read bytes or paket_errc::varnum_too_big
+ */
+template <typename numeric>
+inline int read_zint_unchecked(numeric & value, const byte_t bytes[]) noexcept {
+	if constexpr (std::is_unsigned_v<numeric>) {
+		return read_varnum_unchecked(value, bytes);
+	} else {
+		std::uint64_t result = (bytes[0] >> 1) & 0b00111111;
+		bool sign = bytes[0] & 1;
+		std::size_t n = 1;
+		for (byte_t last = bytes[0]; (last & 0b10000000) != 0; ++n) {
+			if (n == max_zint_size<numeric>())
+				return static_cast<int>(paket_errc::varnum_too_big);
+			last = bytes[n];
+			result |= std::uint64_t(last & 0b01111111) << (7 * (n - 1) + 6);
+		}
+		if (sign)
+			result = 0 - result;
+		value = static_cast<numeric>(result);
+		return static_cast<int>(n);
+	}
+}
+
+} // namespace detail
+
+/**
+ * Finds the end of zint without decoding it.
+ * 
+ * \see skip_varnum
+ */
+template <typename numeric>
+int skip_zint(const byte_t bytes[], std::size_t length) noexcept {
+	int s = detail::skip_varnum(bytes, length, max_zint_size<numeric>());
+	return s == 0 ? static_cast<int>(paket_errc::varnum_too_big) : s;
+}
+
 template <typename numeric>
 std::enable_if_t<std::is_unsigned_v<numeric>, int> write_zint(numeric value, byte_t bytes[], std::size_t length) {
 	return write_varnum(value, bytes, length);
@@ -144,7 +717,7 @@ std::enable_if_t<std::is_signed_v<numeric>, int> write_zint(numeric value, byte_
 		return -1;
 	std::size_t numWrite = 1;
 	byte_t sign = value < 0;
-	std::make_unsigned_t<numeric> uval = sign ? -value : value;
+	std::make_unsigned_t<numeric> uval = detail::magnitude(value);
 	byte_t temp = (static_cast<byte_t>(uval & 0b00111111) << 1) | sign;
 	uval >>= 6;
 	if (uval != 0)
@@ -167,8 +740,57 @@ std::enable_if_t<std::is_signed_v<numeric>, int> write_zint(numeric value, byte_
 }
 
 template <typename numeric>
-std::size_t size_zint(numeric value) {
-	return static_cast<std::size_t>(write_zint(value, nullptr, std::numeric_limits<std::size_t>::max()));
+constexpr std::size_t size_zint(numeric value) noexcept {
+	if constexpr (std::is_unsigned_v<numeric>) {
+		return size_varnum(value);
+	} else {
+		// magnitude and the sign bit
+		std::make_unsigned_t<numeric> uval = detail::magnitude(value);
+		return detail::varnum_size_of_bits(detail::bit_width(uval) + 1);
+	}
+}
+
+/**
+ * Get summary size of several encoded zints.
+ * 
+ * \see size_varnum_bulk
+ */
+template <typename T>
+std::size_t size_zint_bulk(const T values[], std::size_t count) noexcept {
+	std::size_t size = 0;
+	for (std::size_t i = 0; i < count; ++i)
+		size += size_zint(detail::unwrap(values[i]));
+	return size;
+}
+
+/**
+ * Writes several zints one after another.
+ * 
+ * \see write_varnum_bulk
+ */
+template <typename T>
+int write_zint_bulk(const T values[], std::size_t count, byte_t bytes[], std::size_t length) {
+	typedef detail::unwrapped_t<const T> numeric;
+	if constexpr (std::is_unsigned_v<numeric>) {
+		return write_varnum_bulk(values, count, bytes, length);
+	} else {
+		typedef std::make_unsigned_t<numeric> unsigned_t;
+		std::size_t offset = 0;
+		for (std::size_t i = 0; i < count; ++i) {
+			numeric value = detail::unwrap(values[i]);
+			unsigned_t uval = detail::magnitude(value);
+			if (length - offset >= 8 && std::uint64_t(uval) < (std::uint64_t(1) << 55)) {
+				std::uint64_t zval = (std::uint64_t(uval) << 1) | (value < 0);
+				offset += detail::write_varnum_block(zval, bytes + offset);
+				continue;
+			}
+			int s = write_zint(value, bytes + offset, length - offset);
+			if (s < 0)
+				return -1;
+			offset += s;
+		}
+		return static_cast<int>(offset);
+	}
 }
 
 /**
@@ -200,6 +822,275 @@ std::size_t size_varlong(std::int64_t value);
 int read_varlong(const byte_t bytes[], std::size_t length, std::int64_t & value);
 int write_varlong(byte_t bytes[], std::size_t length, std::int64_t value);
 
+/**
+ * Reads several consecutive varnums at once without throwing exceptions.
+ * Each element of the array is either integer or field holding integer value.
+ * 
+ * \param values array for decoded values
+ * \param count number of varnums to read
+ * \return count of read bytes, -1 if array is incomplete or
+ *         paket_errc::varnum_too_big
+ */
+template <typename T>
+int try_read_varnum_bulk(T values[], std::size_t count, const byte_t bytes[], std::size_t length) noexcept {
+	typedef detail::unwrapped_t<T> numeric;
+	std::uint64_t window[8];
+	std::size_t offset = 0;
+	std::size_t i = 0;
+	while (i < count) {
+		if (length - offset >= 8) {
+			std::size_t n;
+			std::size_t s = detail::read_varnum_window(window, count - i, max_varnum_size<numeric>(), bytes + offset, n);
+			if (n != 0) {
+				for (std::size_t k = 0; k < n; ++k)
+					detail::unwrap(values[i + k]) = static_cast<numeric>(window[k]);
+				i += n;
+				offset += s;
+				continue;
+			}
+		}
+		int s = try_read_varnum(detail::unwrap(values[i]), bytes + offset, length - offset);
+		if (s < 0)
+			return s;
+		offset += s;
+		++i;
+	}
+	return static_cast<int>(offset);
+}
+
+/**
+ * Reads several consecutive varnums at once.
+ * 
+ * \see try_read_varnum_bulk
+ * \return count of read bytes or -1 if array is incomplete
+ */
+template <typename T>
+int read_varnum_bulk(T values[], std::size_t count, const byte_t bytes[], std::size_t length) {
+	return detail::checked(try_read_varnum_bulk(values, count, bytes, length));
+}
+
+/**
+ * Reads several consecutive zints at once without throwing exceptions.
+ * 
+ * \see try_read_varnum_bulk
+ */
+template <typename T>
+int try_read_zint_bulk(T values[], std::size_t count, const byte_t bytes[], std::size_t length) noexcept {
+	typedef detail::unwrapped_t<T> numeric;
+	if constexpr (std::is_unsigned_v<numeric>) {
+		return try_read_varnum_bulk(values, count, bytes, length);
+	} else {
+		// signed zint is a varnum with magnitude shifted left and sign in the lowest bit
+		typedef std::make_unsigned_t<numeric> unsigned_t;
+		std::uint64_t window[8];
+		std::size_t offset = 0;
+		std::size_t i = 0;
+		while (i < count) {
+			if (length - offset >= 8) {
+				std::size_t n;
+				std::size_t s = detail::read_varnum_window(window, count - i, max_zint_size<numeric>(), bytes + offset, n);
+				if (n != 0) {
+					for (std::size_t k = 0; k < n; ++k) {
+						unsigned_t magnitude = static_cast<unsigned_t>(window[k] >> 1);
+						if (window[k] & 1)
+							magnitude = -magnitude;
+						detail::unwrap(values[i + k]) = static_cast<numeric>(magnitude);
+					}
+					i += n;
+					offset += s;
+					continue;
+				}
+			}
+			int s = try_read_zint(detail::unwrap(values[i]), bytes + offset, length - offset);
+			if (s < 0)
+				return s;
+			offset += s;
+			++i;
+		}
+		return static_cast<int>(offset);
+	}
+}
+
+/**
+ * Reads several consecutive zints at once.
+ * 
+ * \see read_varnum_bulk
+ */
+template <typename T>
+int read_zint_bulk(T values[], std::size_t count, const byte_t bytes[], std::size_t length) {
+	return detail::checked(try_read_zint_bulk(values, count, bytes, length));
+}
+
+int read_varint_bulk(std::int32_t values[], std::size_t count, const byte_t bytes[], std::size_t length);
+int read_varlong_bulk(std::int64_t values[], std::size_t count, const byte_t bytes[], std::size_t length);
+int write_varint_bulk(const std::int32_t values[], std::size_t count, byte_t bytes[], std::size_t length);
+int write_varlong_bulk(const std::int64_t values[], std::size_t count, byte_t bytes[], std::size_t length);
+
+namespace detail {
+
+template <typename T, typename = void>
+struct has_reference : std::false_type {};
+
+template <typename T>
+struct has_reference<T, std::void_t<decltype(std::declval<T &>().reference(std::declval<const byte_t *>(), std::size_t()))>>
+	: std::true_type {};
+
+template <typename T, typename = void>
+struct has_rewind : std::false_type {};
+
+template <typename T>
+struct has_rewind<T, std::void_t<decltype(std::declval<T &>().rewind(std::declval<T &>().position()))>>
+	: std::true_type {};
+
+/// position to rewind() to, if the sink has `rewind(position)` method
+template <typename sink_t>
+auto mark(sink_t & sink) noexcept {
+	if constexpr (has_rewind<sink_t>::value)
+		return sink.position();
+	else
+		return std::size_t(0);
+}
+
+/**
+ * Drops bytes committed to the sink after the mark, so a failed write
+ * does not leave a partial frame. Sinks without `rewind(position)` method
+ * keep them.
+ * 
+ * \return -1
+ */
+template <typename sink_t, typename position_t>
+int rewind(sink_t & sink, position_t position) {
+	if constexpr (has_rewind<sink_t>::value)
+		sink.rewind(position);
+	return -1;
+}
+
+/**
+ * Appends payload bytes to the sink. Sinks with `reference(bytes, size)`
+ * method may keep pointer to the payload instead of copying it.
+ * 
+ * \return count of written bytes or -1 if the sink has no space
+ */
+template <typename sink_t>
+int write_payload(sink_t & sink, const byte_t bytes[], std::size_t size) {
+	if constexpr (has_reference<sink_t>::value) {
+		sink.reference(bytes, size);
+	} else {
+		byte_t * out = sink.reserve(size);
+		if (out == nullptr)
+			return -1;
+		if (size != 0)
+			std::memcpy(out, bytes, size);
+		sink.commit(size);
+	}
+	return static_cast<int>(size);
+}
+
+/**
+ * Appends varint length and payload bytes to the sink.
+ * 
+ * \see write_payload
+ */
+template <typename sink_t>
+int write_prefixed_payload(sink_t & sink, const byte_t bytes[], std::size_t size) {
+	constexpr std::size_t head_size = max_varnum_size<std::int32_t>();
+	byte_t * head = sink.reserve(head_size);
+	if (head == nullptr)
+		return -1;
+	int k = write_varint(static_cast<std::int32_t>(size), head, head_size);
+	sink.commit(static_cast<std::size_t>(k));
+	int s = write_payload(sink, bytes, size);
+	if (s < 0)
+		return -1;
+	return k + s;
+}
+
+} // namespace detail
+
+/**
+ * \brief Non-owning view of bytes inside some buffer.
+ * 
+ * The view stays valid as long as the viewed buffer does.
+ */
+class byte_span {
+	const byte_t * ptr = nullptr;
+	std::size_t count = 0;
+public:
+	typedef byte_t value_type;
+	typedef const byte_t * iterator;
+	typedef const byte_t * const_iterator;
+	constexpr byte_span() noexcept = default;
+	constexpr byte_span(const byte_t * data, std::size_t size) noexcept : ptr(data), count(size) {}
+	constexpr const byte_t * data() const noexcept {
+		return ptr;
+	}
+	constexpr std::size_t size() const noexcept {
+		return count;
+	}
+	constexpr bool empty() const noexcept {
+		return count == 0;
+	}
+	constexpr const byte_t & operator[](std::size_t pos) const noexcept {
+		return ptr[pos];
+	}
+	constexpr iterator begin() const noexcept {
+		return ptr;
+	}
+	constexpr iterator end() const noexcept {
+		return ptr + count;
+	}
+	friend bool operator==(const byte_span & lhs, const byte_span & rhs) noexcept;
+	friend bool operator!=(const byte_span & lhs, const byte_span & rhs) noexcept {
+		return !(lhs == rhs);
+	}
+};
+
+/**
+ * \brief Limit of memory that decoding may allocate on the current thread.
+ * 
+ * While the budget exists, strings, rest and lists decoded by this thread
+ * charge the size of their data against it. When it runs out, decoding
+ * fails with paket_errc::budget_exceeded. Budgets may be nested, only the
+ * innermost one is charged.
+ */
+class memory_budget {
+	std::size_t left;
+	memory_budget * previous;
+	static thread_local memory_budget * current;
+public:
+	explicit memory_budget(std::size_t limit) noexcept : left(limit), previous(current) {
+		current = this;
+	}
+	memory_budget(const memory_budget &) = delete;
+	memory_budget & operator=(const memory_budget &) = delete;
+	~memory_budget() {
+		current = previous;
+	}
+	std::size_t remaining() const noexcept {
+		return left;
+	}
+	/**
+	 * Sets the new limit, so the same budget can be used for each frame.
+	 */
+	void reset(std::size_t limit) noexcept {
+		left = limit;
+	}
+	/**
+	 * Charges the innermost budget of the current thread, if there is one.
+	 * 
+	 * \return false if the budget does not have enough memory left
+	 */
+	static bool charge(std::size_t size) noexcept {
+		memory_budget * budget = current;
+		if (budget == nullptr)
+			return true;
+		if (size > budget->left)
+			return false;
+		budget->left -= size;
+		return true;
+	}
+};
+
 namespace fields {
 
 	template <typename T>
@@ -225,18 +1116,72 @@ namespace fields {
 		varint() = default;
 		constexpr varint(const value_type & init) : field(init) {}
 		std::size_t size() const noexcept;
-		int read(const byte_t bytes[], std::size_t length);
+		int try_read(const byte_t bytes[], std::size_t length) noexcept;
+		int read(const byte_t bytes[], std::size_t length) {
+			return detail::checked(try_read(bytes, length));
+		}
 		int write(byte_t bytes[], std::size_t length) const;
+		template <typename sink_t>
+		detail::enable_if_sink_t<sink_t> write(sink_t & sink) const {
+			return detail::write_reserved(sink, *this, size());
+		}
 		operator std::string() const;
+		static int read_bulk(varint fields[], std::size_t count, const byte_t bytes[], std::size_t length) noexcept;
+		static std::size_t size_bulk(const varint fields[], std::size_t count) noexcept;
+		static int write_bulk(const varint fields[], std::size_t count, byte_t bytes[], std::size_t length);
+		static constexpr std::size_t min_size() noexcept {
+			return 1;
+		}
+		static constexpr std::size_t max_size() noexcept {
+			return max_varnum_size<value_type>();
+		}
+		static int skip(const byte_t bytes[], std::size_t length) noexcept {
+			return skip_varnum<std::int32_t>(bytes, length);
+		}
+		/// writes the value, there should be at least max_size() bytes
+		std::size_t write_unchecked(byte_t bytes[]) const noexcept {
+			return detail::write_varnum_unchecked(value, bytes);
+		}
+		/// reads the value, there should be at least max_size() bytes
+		int read_unchecked(const byte_t bytes[]) noexcept {
+			return detail::read_varnum_unchecked(value, bytes);
+		}
 	};
 
 	struct varlong : public field<std::int64_t> {
 		varlong() = default;
 		constexpr varlong(const value_type & init) : field(init) {}
 		std::size_t size() const noexcept;
-		int read(const byte_t bytes[], std::size_t length);
+		int try_read(const byte_t bytes[], std::size_t length) noexcept;
+		int read(const byte_t bytes[], std::size_t length) {
+			return detail::checked(try_read(bytes, length));
+		}
 		int write(byte_t bytes[], std::size_t length) const;
+		template <typename sink_t>
+		detail::enable_if_sink_t<sink_t> write(sink_t & sink) const {
+			return detail::write_reserved(sink, *this, size());
+		}
 		operator std::string() const;
+		static int read_bulk(varlong fields[], std::size_t count, const byte_t bytes[], std::size_t length) noexcept;
+		static std::size_t size_bulk(const varlong fields[], std::size_t count) noexcept;
+		static int write_bulk(const varlong fields[], std::size_t count, byte_t bytes[], std::size_t length);
+		static constexpr std::size_t min_size() noexcept {
+			return 1;
+		}
+		static constexpr std::size_t max_size() noexcept {
+			return max_varnum_size<value_type>();
+		}
+		static int skip(const byte_t bytes[], std::size_t length) noexcept {
+			return skip_varnum<std::int64_t>(bytes, length);
+		}
+		/// writes the value, there should be at least max_size() bytes
+		std::size_t write_unchecked(byte_t bytes[]) const noexcept {
+			return detail::write_varnum_unchecked(value, bytes);
+		}
+		/// reads the value, there should be at least max_size() bytes
+		int read_unchecked(const byte_t bytes[]) noexcept {
+			return detail::read_varnum_unchecked(value, bytes);
+		}
 	};
 
 	template <typename T>
@@ -247,26 +1192,154 @@ namespace fields {
 		std::size_t size() const noexcept {
 			return size_zint(this->value);
 		}
+		int try_read(const byte_t bytes[], std::size_t length) noexcept {
+			return try_read_zint(this->value, bytes, length);
+		}
 		int read(const byte_t bytes[], std::size_t length) {
-			return read_zint(this->value, bytes, length);
+			return detail::checked(try_read(bytes, length));
 		}
 		int write(byte_t bytes[], std::size_t length) const {
 			return write_zint(this->value, bytes, length);
 		}
+		template <typename sink_t>
+		detail::enable_if_sink_t<sink_t> write(sink_t & sink) const {
+			return detail::write_reserved(sink, *this, size());
+		}
 		operator std::string() const {
 			return std::to_string(this->value);
 		}
+		static int read_bulk(zint fields[], std::size_t count, const byte_t bytes[], std::size_t length) noexcept {
+			return try_read_zint_bulk(fields, count, bytes, length);
+		}
+		static std::size_t size_bulk(const zint fields[], std::size_t count) noexcept {
+			return size_zint_bulk(fields, count);
+		}
+		static int write_bulk(const zint fields[], std::size_t count, byte_t bytes[], std::size_t length) {
+			return write_zint_bulk(fields, count, bytes, length);
+		}
+		static constexpr std::size_t min_size() noexcept {
+			return 1;
+		}
+		static constexpr std::size_t max_size() noexcept {
+			return max_zint_size<T>();
+		}
+		static int skip(const byte_t bytes[], std::size_t length) noexcept {
+			return skip_zint<T>(bytes, length);
+		}
+		/// writes the value, there should be at least max_size() bytes
+		std::size_t write_unchecked(byte_t bytes[]) const noexcept {
+			return detail::write_zint_unchecked(this->value, bytes);
+		}
+		/// reads the value, there should be at least max_size() bytes
+		int read_unchecked(const byte_t bytes[]) noexcept {
+			return detail::read_zint_unchecked(this->value, bytes);
+		}
+	};
+
+	template <typename T, typename = void>
+	struct has_bulk_read : std::false_type {};
+
+	template <typename T>
+	struct has_bulk_read<T, std::void_t<decltype(T::read_bulk(std::declval<T *>(), 0, nullptr, 0))>> : std::true_type {};
+
+	template <typename T, typename = void>
+	struct has_bulk_write : std::false_type {};
+
+	template <typename T>
+	struct has_bulk_write<T, std::void_t<decltype(T::size_bulk(std::declval<const T *>(), 0)),
+								decltype(T::write_bulk(std::declval<const T *>(), 0, nullptr, 0))>> : std::true_type {};
+
+	template <typename T, typename = void>
+	struct has_static_size : std::false_type {};
+
+	template <typename T>
+	struct has_static_size<T, std::void_t<decltype(T::static_size())>> : std::true_type {};
+
+	/// field has bounded size and can be encoded with write_unchecked()
+	template <typename T, typename = void>
+	struct has_max_size : std::false_type {};
+
+	template <typename T>
+	struct has_max_size<T, std::void_t<decltype(T::max_size())>> : std::true_type {};
+
+	/// decoded value refers to the source buffer instead of owning its data
+	template <typename T>
+	struct is_source_view : std::false_type {};
+
+	/**
+	 * \brief Leading run of fields with static size.
+	 *
+	 * Paket encodes and decodes such a run as one block with a single
+	 * bounds check, the offset of every field in the run is a constant.
+	 */
+	template <typename ...fields_t>
+	struct static_run {
+		static constexpr std::size_t count = 0;
+		static constexpr std::size_t size = 0;
+	};
+
+	template <typename first, typename ...other>
+	struct static_run<first, other...> {
+	private:
+		static constexpr std::size_t first_size() noexcept {
+			if constexpr (has_static_size<first>::value)
+				return first::static_size();
+			else
+				return 0;
+		}
+	public:
+		static constexpr std::size_t count = has_static_size<first>::value ? 1 + static_run<other...>::count : 0;
+		static constexpr std::size_t size = has_static_size<first>::value ? first_size() + static_run<other...>::size : 0;
 	};
 
 	struct string : public field<std::string> {
 		string() = default;
 		constexpr string(const value_type & init) : field(init) {}
 		std::size_t size() const noexcept;
-		int read(const byte_t bytes[], std::size_t length);
+		int try_read(const byte_t bytes[], std::size_t length);
+		int read(const byte_t bytes[], std::size_t length) {
+			return detail::checked(try_read(bytes, length));
+		}
+		int write(byte_t bytes[], std::size_t length) const;
+		static constexpr std::size_t min_size() noexcept {
+			return 1;
+		}
+		static int skip(const byte_t bytes[], std::size_t length) noexcept;
+		template <typename sink_t>
+		detail::enable_if_sink_t<sink_t> write(sink_t & sink) const {
+			return detail::write_prefixed_payload(sink, reinterpret_cast<const byte_t *>(value.data()), value.size());
+		}
+		operator std::string() const;
+	};
+
+	/**
+	 * \brief String field that refers to the characters in the decoded buffer
+	 * instead of copying them.
+	 * 
+	 * Decoded value stays valid as long as the source buffer does.
+	 */
+	struct string_view : public field<std::string_view> {
+		string_view() = default;
+		constexpr string_view(const value_type & init) : field(init) {}
+		std::size_t size() const noexcept;
+		int try_read(const byte_t bytes[], std::size_t length);
+		int read(const byte_t bytes[], std::size_t length) {
+			return detail::checked(try_read(bytes, length));
+		}
 		int write(byte_t bytes[], std::size_t length) const;
+		static constexpr std::size_t min_size() noexcept {
+			return 1;
+		}
+		static int skip(const byte_t bytes[], std::size_t length) noexcept;
+		template <typename sink_t>
+		detail::enable_if_sink_t<sink_t> write(sink_t & sink) const {
+			return detail::write_prefixed_payload(sink, reinterpret_cast<const byte_t *>(value.data()), value.size());
+		}
 		operator std::string() const;
 	};
 
+	template <> struct is_source_view<string_view> : std::true_type {};
+
 	template <typename T>
 	struct static_size_field : public field<T> {
 		static constexpr std::size_t static_size() noexcept {
@@ -277,37 +1350,88 @@ namespace fields {
 		constexpr std::size_t size() const noexcept {
 			return static_size();
 		}
-	private:
-		static inline constexpr T phtons(T number) {
-#			ifdef PAKET_BIG_ENDIAN
-				return number;
-#			else
-				constexpr std::size_t n = static_size();
-				union {
-					T number;
-					byte_t data[n];
-				} tmp { number };
-				for (std::size_t i = 0; i < n/2; ++i) {
-					byte_t z = tmp.data[i];
-					tmp.data[i] = tmp.data[n - i - 1];
-					tmp.data[n - i - 1] = z;
-				}
-				return tmp.number;
-#			endif
-		}
-	public:
-		int read(const byte_t bytes[], std::size_t length) {
+		int try_read(const byte_t bytes[], std::size_t length) noexcept {
 			if (length < static_size())
 				return -1;
-			field<T>::value = phtons(*(reinterpret_cast<const typename field<T>::value_type *>(bytes)));
+			if constexpr (std::is_same_v<T, bool>)
+				field<T>::value = bytes[0] != 0;
+			else
+				field<T>::value = detail::load_big_endian<T>(bytes);
 			return static_size();
 		}
+		int read(const byte_t bytes[], std::size_t length) noexcept {
+			return try_read(bytes, length);
+		}
 		int write(byte_t bytes[], std::size_t length) const {
 			if (length < static_size())
 				return -1;
-			*(reinterpret_cast<typename field<T>::value_type *>(bytes)) = phtons(field<T>::value);
+			detail::store_big_endian<T>(bytes, field<T>::value);
 			return static_size();
 		}
+		static constexpr std::size_t min_size() noexcept {
+			return static_size();
+		}
+		static constexpr std::size_t max_size() noexcept {
+			return static_size();
+		}
+		static constexpr int skip(const byte_t *, std::size_t length) noexcept {
+			return length < static_size() ? -1 : static_cast<int>(static_size());
+		}
+		/// writes the value, there should be at least static_size() bytes
+		std::size_t write_unchecked(byte_t bytes[]) const noexcept {
+			detail::store_big_endian<T>(bytes, field<T>::value);
+			return static_size();
+		}
+		/// reads the value, there should be at least static_size() bytes
+		int read_unchecked(const byte_t bytes[]) noexcept {
+			if constexpr (std::is_same_v<T, bool>)
+				field<T>::value = bytes[0] != 0;
+			else
+				field<T>::value = detail::load_big_endian<T>(bytes);
+			return static_cast<int>(static_size());
+		}
+		/**
+		 * Reads count values into the array of fields, reversing bytes of
+		 * the whole array at once.
+		 *
+		 * \return count of read bytes or -1 if there is not enough data
+		 */
+		template <typename field_t>
+		static int read_bulk(field_t fields[], std::size_t count, const byte_t bytes[], std::size_t length) noexcept {
+			static_assert(sizeof(field_t) == sizeof(T) && std::is_base_of_v<static_size_field, field_t>);
+			std::size_t size = count * static_size();
+			if (length < size)
+				return -1;
+			if constexpr (std::is_same_v<T, bool>) {
+				for (std::size_t i = 0; i < count; ++i)
+					fields[i].value = bytes[i] != 0;
+			} else {
+				detail::copy_big_endian(reinterpret_cast<byte_t *>(fields), bytes, count, static_size());
+			}
+			return static_cast<int>(size);
+		}
+		template <typename field_t>
+		static constexpr std::size_t size_bulk(const field_t *, std::size_t count) noexcept {
+			return count * static_size();
+		}
+		/**
+		 * Writes the array of fields, reversing bytes of the whole array at once.
+		 *
+		 * \return count of written bytes or -1 if buffer is too small
+		 */
+		template <typename field_t>
+		static int write_bulk(const field_t fields[], std::size_t count, byte_t bytes[], std::size_t length) noexcept {
+			static_assert(sizeof(field_t) == sizeof(T) && std::is_base_of_v<static_size_field, field_t>);
+			std::size_t size = count * static_size();
+			if (length < size)
+				return -1;
+			detail::copy_big_endian(bytes, reinterpret_cast<const byte_t *>(fields), count, static_size());
+			return static_cast<int>(size);
+		}
+		template <typename sink_t>
+		detail::enable_if_sink_t<sink_t> write(sink_t & sink) const {
+			return detail::write_reserved(sink, *this, static_size());
+		}
 		operator std::string() const {
 			return std::to_string(field<T>::value);
 		}
@@ -331,52 +1455,164 @@ namespace fields {
 		constexpr uint16(const value_type & init) : static_size_field(init) {}
 	};
 
+	struct int16 : public static_size_field<std::int16_t> {
+		int16() = default;
+		constexpr int16(const value_type & init) : static_size_field(init) {}
+	};
+
+	struct int32 : public static_size_field<std::int32_t> {
+		int32() = default;
+		constexpr int32(const value_type & init) : static_size_field(init) {}
+	};
+
+	struct uint32 : public static_size_field<std::uint32_t> {
+		uint32() = default;
+		constexpr uint32(const value_type & init) : static_size_field(init) {}
+	};
+
 	struct int64 : public static_size_field<std::int64_t> {
 		int64() = default;
 		constexpr int64(const value_type & init) : static_size_field(init) {}
 	};
 
-	struct rest : public field<std::vector<byte_t>> {
-		rest() = default;
-		rest(const value_type & init) : field(init) {}
-		std::size_t size() const noexcept {
+	struct uint64 : public static_size_field<std::uint64_t> {
+		uint64() = default;
+		constexpr uint64(const value_type & init) : static_size_field(init) {}
+	};
+
+	/// IEEE 754 single precision number
+	struct float32 : public static_size_field<float> {
+		static_assert(sizeof(float) == 4 && std::numeric_limits<float>::is_iec559);
+		float32() = default;
+		constexpr float32(const value_type & init) : static_size_field(init) {}
+	};
+
+	/// IEEE 754 double precision number
+	struct float64 : public static_size_field<double> {
+		static_assert(sizeof(double) == 8 && std::numeric_limits<double>::is_iec559);
+		float64() = default;
+		constexpr float64(const value_type & init) : static_size_field(init) {}
+	};
+
+	struct rest : public field<std::vector<byte_t>> {
+		rest() = default;
+		rest(const value_type & init) : field(init) {}
+		std::size_t size() const noexcept {
+			return value.size();
+		}
+		int try_read(const byte_t bytes[], std::size_t length);
+		int read(const byte_t bytes[], std::size_t length) {
+			return detail::checked(try_read(bytes, length));
+		}
+		int write(byte_t bytes[], std::size_t length) const;
+		static constexpr std::size_t min_size() noexcept {
+			return 0;
+		}
+		static constexpr int skip(const byte_t *, std::size_t length) noexcept {
+			return static_cast<int>(length);
+		}
+		template <typename sink_t>
+		detail::enable_if_sink_t<sink_t> write(sink_t & sink) const {
+			return detail::write_payload(sink, value.data(), value.size());
+		}
+		operator std::string() const;
+	};
+
+	/**
+	 * \brief Same as rest, but refers to the remaining bytes of the decoded
+	 * buffer instead of copying them.
+	 * 
+	 * Decoded value stays valid as long as the source buffer does.
+	 */
+	struct bytes_view : public field<byte_span> {
+		bytes_view() = default;
+		constexpr bytes_view(const value_type & init) : field(init) {}
+		constexpr std::size_t size() const noexcept {
 			return value.size();
 		}
-		int read(const byte_t bytes[], std::size_t length);
+		int try_read(const byte_t bytes[], std::size_t length);
+		int read(const byte_t bytes[], std::size_t length) {
+			return detail::checked(try_read(bytes, length));
+		}
 		int write(byte_t bytes[], std::size_t length) const;
+		static constexpr std::size_t min_size() noexcept {
+			return 0;
+		}
+		static constexpr int skip(const byte_t *, std::size_t length) noexcept {
+			return static_cast<int>(length);
+		}
+		template <typename sink_t>
+		detail::enable_if_sink_t<sink_t> write(sink_t & sink) const {
+			return detail::write_payload(sink, value.data(), value.size());
+		}
 		operator std::string() const;
 	};
 
-	template <typename T>
-	struct list : public field<std::vector<T>> {
+	template <> struct is_source_view<bytes_view> : std::true_type {};
+
+	/**
+	 * \brief List of fields stored in a vector-like container.
+	 * 
+	 * \see list
+	 */
+	template <typename T, typename container_t>
+	struct basic_list : public field<container_t> {
 		typedef T list_element;
 
+		basic_list() = default;
+		basic_list(const container_t & init) : field<container_t>(init) {}
+		basic_list(container_t && init) : field<container_t>(std::move(init)) {}
+
 		std::size_t size() const noexcept {
 			std::size_t sz = size_varint(static_cast<std::int32_t>(this->value.size()));
+			if constexpr (has_bulk_write<T>::value)
+				return sz + T::size_bulk(this->value.data(), this->value.size());
 			for (const auto & f : this->value)
 				sz += f.size();
 			return sz;
 		}
-		int read(const byte_t bytes[], std::size_t length) {
+		int try_read(const byte_t bytes[], std::size_t length) {
 			std::int32_t sz;
-			int offset = read_varint(sz, bytes, length);
-			if (offset == -1)
-				return -1;
+			int offset = try_read_varnum(sz, bytes, length);
+			if (offset < 0)
+				return offset;
 			if (sz < 0)
-				throw paket_error("list size '" + std::to_string(sz) + "' is lower then 0");
+				return static_cast<int>(paket_errc::negative_length);
+			// count is not trusted until there is enough data for all the elements
+			if constexpr (T::min_size() != 0) {
+				if (static_cast<std::size_t>(sz) > (length - offset) / T::min_size())
+					return -1;
+			}
+			if (!memory_budget::charge(static_cast<std::size_t>(sz) * sizeof(T)))
+				return static_cast<int>(paket_errc::budget_exceeded);
 			this->value.resize(sz);
+			if constexpr (has_bulk_read<T>::value) {
+				int s = T::read_bulk(this->value.data(), this->value.size(), bytes + offset, length - offset);
+				if (s < 0)
+					return s;
+				return offset + s;
+			}
 			for (T & f : this->value) {
-				int s = f.read(bytes + offset, length - offset);
-				if (s == -1)
-					return -1;
+				int s = f.try_read(bytes + offset, length - offset);
+				if (s < 0)
+					return s;
 				offset += s;
 			}
 			return offset;
 		}
+		int read(const byte_t bytes[], std::size_t length) {
+			return detail::checked(try_read(bytes, length));
+		}
 		int write(byte_t bytes[], std::size_t length) const {
 			int offset = write_varint(static_cast<std::int32_t>(this->value.size()), bytes, length);
 			if (offset == -1)
 				return -1;
+			if constexpr (has_bulk_write<T>::value) {
+				int s = T::write_bulk(this->value.data(), this->value.size(), bytes + offset, length - offset);
+				if (s == -1)
+					return -1;
+				return offset + s;
+			}
 			for (const T & f : this->value) {
 				int s = f.write(bytes + offset, length - offset);
 				if (s == -1)
@@ -385,6 +1621,67 @@ namespace fields {
 			}
 			return offset;
 		}
+		static constexpr std::size_t min_size() noexcept {
+			return 1;
+		}
+		/**
+		 * Finds the end of the list without decoding its elements. Elements
+		 * of static size are skipped all at once.
+		 * 
+		 * \return size of the list, -1 if there is not enough data or
+		 *         other paket_errc code if the list is malformed
+		 */
+		static int skip(const byte_t bytes[], std::size_t length) noexcept {
+			std::int32_t sz;
+			int offset = try_read_varnum(sz, bytes, length);
+			if (offset < 0)
+				return offset;
+			if (sz < 0)
+				return static_cast<int>(paket_errc::negative_length);
+			if constexpr (has_static_size<T>::value) {
+				std::uint64_t size = std::uint64_t(sz) * T::static_size();
+				if (size > length - offset)
+					return -1;
+				return offset + static_cast<int>(size);
+			}
+			for (std::int32_t i = 0; i < sz; ++i) {
+				int s = T::skip(bytes + offset, length - offset);
+				if (s < 0)
+					return s;
+				offset += s;
+			}
+			return offset;
+		}
+		template <typename sink_t>
+		detail::enable_if_sink_t<sink_t> write(sink_t & sink) const {
+			if constexpr (std::is_same_v<T, byte>) {
+				// list of bytes has the same representation as the byte array
+				static_assert(sizeof(T) == 1);
+				return detail::write_prefixed_payload(sink, reinterpret_cast<const byte_t *>(this->value.data()), this->value.size());
+			}
+			varint count = static_cast<std::int32_t>(this->value.size());
+			int offset = count.write(sink);
+			if (offset == -1)
+				return -1;
+			if constexpr (has_bulk_write<T>::value) {
+				std::size_t size = T::size_bulk(this->value.data(), this->value.size());
+				byte_t * bytes = sink.reserve(size);
+				if (bytes == nullptr)
+					return -1;
+				int s = T::write_bulk(this->value.data(), this->value.size(), bytes, size);
+				if (s == -1)
+					return -1;
+				sink.commit(static_cast<std::size_t>(s));
+				return offset + s;
+			}
+			for (const T & f : this->value) {
+				int s = f.write(sink);
+				if (s == -1)
+					return -1;
+				offset += s;
+			}
+			return offset;
+		}
 		operator std::string() const {
 			if (this->value.empty())
 				return "[ ]";
@@ -395,12 +1692,282 @@ namespace fields {
 		}
 	};
 
+	template <typename T>
+	struct list : public basic_list<T, std::vector<T>> {};
+
 	template <> struct list<std::int32_t> : public list<varint> {};
 	template <> struct list<std::int64_t> : public list<varlong> {};
 	template <> struct list<std::string> : public list<string> {};
+	template <> struct list<std::string_view> : public list<string_view> {};
 	template <> struct list<bool> : public list<boolean> {};
 	template <> struct list<byte_t> : public list<byte> {};
 	template <> struct list<std::uint16_t> : public list<uint16> {};
+	template <> struct list<std::int16_t> : public list<int16> {};
+	template <> struct list<std::uint32_t> : public list<uint32> {};
+	template <> struct list<std::uint64_t> : public list<uint64> {};
+	template <> struct list<float> : public list<float32> {};
+	template <> struct list<double> : public list<float64> {};
+
+	/**
+	 * \brief Array of N values of static size without length prefix.
+	 * 
+	 * Bytes of all the values are reversed at once, which is much faster
+	 * than one by one for large arrays like heightmaps.
+	 */
+	template <typename T, std::size_t N>
+	struct array : public field<std::array<typename T::value_type, N>> {
+		static_assert(has_static_size<T>::value, "array element must have static size");
+		typedef T list_element;
+		typedef std::array<typename T::value_type, N> value_type;
+
+		static constexpr std::size_t static_size() noexcept {
+			return N * T::static_size();
+		}
+		array() = default;
+		constexpr array(const value_type & init) : field<value_type>(init) {}
+		constexpr std::size_t size() const noexcept {
+			return static_size();
+		}
+		int try_read(const byte_t bytes[], std::size_t length) noexcept {
+			if (length < static_size())
+				return -1;
+			if constexpr (std::is_same_v<typename T::value_type, bool>) {
+				for (std::size_t i = 0; i < N; ++i)
+					this->value[i] = bytes[i] != 0;
+			} else {
+				detail::copy_big_endian(reinterpret_cast<byte_t *>(this->value.data()), bytes, N, T::static_size());
+			}
+			return static_cast<int>(static_size());
+		}
+		int read(const byte_t bytes[], std::size_t length) noexcept {
+			return try_read(bytes, length);
+		}
+		int write(byte_t bytes[], std::size_t length) const noexcept {
+			if (length < static_size())
+				return -1;
+			detail::copy_big_endian(bytes, reinterpret_cast<const byte_t *>(this->value.data()), N, T::static_size());
+			return static_cast<int>(static_size());
+		}
+		static constexpr std::size_t min_size() noexcept {
+			return static_size();
+		}
+		static constexpr std::size_t max_size() noexcept {
+			return static_size();
+		}
+		static constexpr int skip(const byte_t *, std::size_t length) noexcept {
+			return length < static_size() ? -1 : static_cast<int>(static_size());
+		}
+		/// writes the values, there should be at least static_size() bytes
+		std::size_t write_unchecked(byte_t bytes[]) const noexcept {
+			write(bytes, static_size());
+			return static_size();
+		}
+		/// reads the values, there should be at least static_size() bytes
+		int read_unchecked(const byte_t bytes[]) noexcept {
+			return try_read(bytes, static_size());
+		}
+		template <typename sink_t>
+		detail::enable_if_sink_t<sink_t> write(sink_t & sink) const {
+			return detail::write_reserved(sink, *this, static_size());
+		}
+		operator std::string() const {
+			if (N == 0)
+				return "[ ]";
+			std::string result = "[" + std::string(T(this->value[0]));
+			for (std::size_t i = 1; i < N; ++i)
+				result += ", " + std::string(T(this->value[i]));
+			return result + "]";
+		}
+	};
+
+	/**
+	 * \brief Entries of bits each packed into longs, like block states of a
+	 * Minecraft chunk section.
+	 * 
+	 * Value is the array of unpacked entries (palette indices). On the wire
+	 * it is a varint count of longs followed by big endian longs, so it is
+	 * compatible with list<fields::int64>. Entries are unpacked and packed
+	 * with AVX2 when the processor supports it.
+	 */
+	template <unsigned bits, std::size_t count, bit_packing packing = bit_packing::padded, typename index_t = std::uint16_t>
+	struct packed_bits : public field<std::array<index_t, count>> {
+		static_assert(std::is_same_v<index_t, std::uint16_t> || std::is_same_v<index_t, std::uint32_t>,
+			"entries are unpacked to std::uint16_t or std::uint32_t");
+		static_assert(bits > 0 && bits <= 8 * sizeof(index_t), "entry does not fit the index type");
+		typedef std::array<index_t, count> value_type;
+
+		/// count of longs on the wire
+		static constexpr std::size_t words() noexcept {
+			return detail::packed_words(count, bits, packing);
+		}
+		packed_bits() = default;
+		constexpr packed_bits(const value_type & init) : field<value_type>(init) {}
+		static constexpr std::size_t size() noexcept {
+			return size_varnum(static_cast<std::int32_t>(words())) + words() * 8;
+		}
+		int try_read(const byte_t bytes[], std::size_t length) noexcept {
+			int k = skip_head(bytes, length);
+			if (k < 0)
+				return k;
+			detail::unpack_bits(this->value.data(), count, bytes + k, bits, packing);
+			return k + static_cast<int>(words() * 8);
+		}
+		int read(const byte_t bytes[], std::size_t length) {
+			return detail::checked(try_read(bytes, length));
+		}
+		int write(byte_t bytes[], std::size_t length) const noexcept {
+			if (length < size())
+				return -1;
+			write_unchecked(bytes);
+			return static_cast<int>(size());
+		}
+		static constexpr std::size_t min_size() noexcept {
+			return size();
+		}
+		/// count of longs may be encoded longer than size() assumes
+		static constexpr std::size_t max_size() noexcept {
+			return max_varnum_size<std::int32_t>() + words() * 8;
+		}
+		static int skip(const byte_t bytes[], std::size_t length) noexcept {
+			int k = skip_head(bytes, length);
+			return k < 0 ? k : k + static_cast<int>(words() * 8);
+		}
+		/// writes the entries, there should be at least size() bytes
+		std::size_t write_unchecked(byte_t bytes[]) const noexcept {
+			std::size_t k = detail::write_varnum_unchecked(static_cast<std::int32_t>(words()), bytes);
+			detail::pack_bits(bytes + k, this->value.data(), count, bits, packing);
+			return size();
+		}
+		/// reads the entries, there should be at least max_size() bytes
+		int read_unchecked(const byte_t bytes[]) noexcept {
+			return try_read(bytes, max_size());
+		}
+		template <typename sink_t>
+		detail::enable_if_sink_t<sink_t> write(sink_t & sink) const {
+			return detail::write_reserved(sink, *this, size());
+		}
+		operator std::string() const {
+			if (count == 0)
+				return "[ ]";
+			std::string result = "[" + std::to_string(this->value[0]);
+			for (std::size_t i = 1; i < count; ++i)
+				result += ", " + std::to_string(this->value[i]);
+			return result + "]";
+		}
+	private:
+		// checks count of longs, \return size of the count or error
+		static int skip_head(const byte_t bytes[], std::size_t length) noexcept {
+			std::int32_t words_count;
+			int k = try_read_varnum(words_count, bytes, length);
+			if (k < 0)
+				return k;
+			if (words_count < 0)
+				return static_cast<int>(paket_errc::negative_length);
+			if (static_cast<std::size_t>(words_count) != words())
+				return static_cast<int>(paket_errc::wrong_size);
+			if (length - k < words() * 8)
+				return -1;
+			return k;
+		}
+	};
+
+	/**
+	 * Fields that allocate memory through std::pmr::polymorphic_allocator.
+	 * 
+	 * Paket with these fields should be constructed with an allocator, see
+	 * paket(std::allocator_arg_t, const alloc_t &). Then a whole batch of
+	 * decoded pakets can live in one arena like monotonic_buffer_resource.
+	 */
+	namespace pmr {
+
+		struct string : public field<std::pmr::string> {
+			typedef std::pmr::polymorphic_allocator<char> allocator_type;
+			string() = default;
+			explicit string(const allocator_type & alloc) : field(value_type(alloc)) {}
+			string(const string & other) = default;
+			string(string && other) = default;
+			string(const string & other, const allocator_type & alloc) : field(value_type(other.value, alloc)) {}
+			string(string && other, const allocator_type & alloc) : field(value_type(std::move(other.value), alloc)) {}
+			string(const value_type & init) : field(init) {}
+			string & operator=(const string & other) = default;
+			string & operator=(string && other) = default;
+			std::size_t size() const noexcept;
+			int try_read(const byte_t bytes[], std::size_t length);
+			int read(const byte_t bytes[], std::size_t length) {
+				return detail::checked(try_read(bytes, length));
+			}
+			int write(byte_t bytes[], std::size_t length) const;
+			static constexpr std::size_t min_size() noexcept {
+				return 1;
+			}
+			static int skip(const byte_t bytes[], std::size_t length) noexcept {
+				return fields::string::skip(bytes, length);
+			}
+			template <typename sink_t>
+			detail::enable_if_sink_t<sink_t> write(sink_t & sink) const {
+				return detail::write_prefixed_payload(sink, reinterpret_cast<const byte_t *>(value.data()), value.size());
+			}
+			operator std::string() const;
+		};
+
+		struct rest : public field<std::pmr::vector<byte_t>> {
+			typedef std::pmr::polymorphic_allocator<byte_t> allocator_type;
+			rest() = default;
+			explicit rest(const allocator_type & alloc) : field(value_type(alloc)) {}
+			rest(const rest & other) = default;
+			rest(rest && other) = default;
+			rest(const rest & other, const allocator_type & alloc) : field(value_type(other.value, alloc)) {}
+			rest(rest && other, const allocator_type & alloc) : field(value_type(std::move(other.value), alloc)) {}
+			rest(const value_type & init) : field(init) {}
+			rest & operator=(const rest & other) = default;
+			rest & operator=(rest && other) = default;
+			std::size_t size() const noexcept {
+				return value.size();
+			}
+			int try_read(const byte_t bytes[], std::size_t length);
+			int read(const byte_t bytes[], std::size_t length) {
+				return detail::checked(try_read(bytes, length));
+			}
+			int write(byte_t bytes[], std::size_t length) const;
+			static constexpr std::size_t min_size() noexcept {
+				return 0;
+			}
+			static constexpr int skip(const byte_t *, std::size_t length) noexcept {
+				return static_cast<int>(length);
+			}
+			template <typename sink_t>
+			detail::enable_if_sink_t<sink_t> write(sink_t & sink) const {
+				return detail::write_payload(sink, value.data(), value.size());
+			}
+			operator std::string() const;
+		};
+
+		template <typename T>
+		struct list : public basic_list<T, std::pmr::vector<T>> {
+			typedef std::pmr::polymorphic_allocator<T> allocator_type;
+			list() = default;
+			explicit list(const allocator_type & alloc) : basic_list<T, std::pmr::vector<T>>(std::pmr::vector<T>(alloc)) {}
+			list(const list & other) = default;
+			list(list && other) = default;
+			list(const list & other, const allocator_type & alloc)
+				: basic_list<T, std::pmr::vector<T>>(std::pmr::vector<T>(other.value, alloc)) {}
+			list(list && other, const allocator_type & alloc)
+				: basic_list<T, std::pmr::vector<T>>(std::pmr::vector<T>(std::move(other.value), alloc)) {}
+			list & operator=(const list & other) = default;
+			list & operator=(list && other) = default;
+		};
+
+		template <> struct list<std::int32_t> : public list<varint> {
+			using list<varint>::list;
+		};
+		template <> struct list<std::int64_t> : public list<varlong> {
+			using list<varlong>::list;
+		};
+		template <> struct list<std::string> : public list<string> {
+			using list<string>::list;
+		};
+
+	} // namespace pmr
 }
 
 template <typename Iter>
@@ -494,10 +2061,10 @@ public:
 	typedef const value_type & const_reference;
 	typedef value_type * pointer;
 	typedef const value_type * const_pointer;
-	typedef list_wrapper_iterator<typename std::vector<field_type>::iterator> iterator;
-	typedef list_wrapper_iterator<typename std::vector<field_type>::const_iterator> const_iterator;
-	typedef list_wrapper_iterator<typename std::vector<field_type>::reverse_iterator> reverse_iterator;
-	typedef list_wrapper_iterator<typename std::vector<field_type>::const_reverse_iterator> const_reverse_iterator;
+	typedef list_wrapper_iterator<typename std::remove_const_t<List>::iterator> iterator;
+	typedef list_wrapper_iterator<typename std::remove_const_t<List>::const_iterator> const_iterator;
+	typedef list_wrapper_iterator<typename std::remove_const_t<List>::reverse_iterator> reverse_iterator;
+	typedef list_wrapper_iterator<typename std::remove_const_t<List>::const_reverse_iterator> const_reverse_iterator;
 
 	constexpr list_wrapper(List & vector) : ref(vector) {};
 
@@ -631,8 +2198,33 @@ public:
 	}
 };
 
+/**
+ * Peeks at the frame length and the paket id without throwing exceptions.
+ * Frame itself may be incomplete.
+ * 
+ * \return size of the frame length or the reason of failure with offset
+ *         of the malformed varint
+ */
+read_result try_head(const byte_t bytes[], std::size_t length, std::int32_t & size, std::int32_t & id) noexcept;
+
+/**
+ * \return size of the frame length or -1 if there is not enough data
+ * \throws paket_error if frame length or paket id is malformed
+ */
 int head(const byte_t bytes[], std::size_t length, std::int32_t & size, std::int32_t & id);
 
+/**
+ * \brief Encoding of the frame length for paket::write_once().
+ */
+enum class length_encoding : std::size_t {
+	/// shortest varint, body is moved after its length becomes known
+	minimal = 0,
+	/// varint padded to 3 bytes, enough for frames up to 2 MiB
+	padded3 = 3,
+	/// varint padded to 5 bytes, enough for any frame
+	padded5 = 5,
+};
+
 template <std::int32_t paket_id, typename ...fields_t>
 class paket : public std::tuple<fields_t...> {
 private:
@@ -645,6 +2237,12 @@ private:
 	}
 public:
 	paket() {}
+	/**
+	 * Constructs paket, so that its allocator-aware fields use the
+	 * specified allocator. Other fields are constructed by default.
+	 */
+	template <typename alloc_t>
+	paket(std::allocator_arg_t, const alloc_t & alloc) : std::tuple<fields_t...>(std::allocator_arg, alloc) {}
 	std::size_t size() const {
 		auto size_them = [](auto const &... e) -> std::size_t {
 			return size_field(e...);
@@ -683,33 +2281,149 @@ public:
 	constexpr std::int32_t id() const noexcept {
 		return paket_id;
 	}
+	static constexpr std::int32_t static_id() noexcept {
+		return paket_id;
+	}
+	static constexpr std::size_t fields_count() noexcept {
+		return sizeof...(fields_t);
+	}
+	/**
+	 * Paket is bounded if all its fields have maximal size. Bounded pakets
+	 * have max_size() and can be encoded with write_unchecked().
+	 */
+	static constexpr bool is_bounded() noexcept {
+		return (fields::has_max_size<fields_t>::value && ...);
+	}
+	/// minimal size of the paket body
+	static constexpr std::size_t min_size() noexcept {
+		return (std::size_t(0) + ... + fields_t::min_size());
+	}
+	/// maximal size of the paket body
+	static constexpr std::size_t max_size() noexcept {
+		static_assert(is_bounded(), "paket has fields of unbounded size");
+		if constexpr (is_bounded())
+			return (std::size_t(0) + ... + fields_t::max_size());
+		else
+			return 0;
+	}
+	/// maximal size of the frame with minimal length encoding, enough for a stack buffer
+	static constexpr std::size_t max_frame_size() noexcept {
+		std::size_t body = size_varnum(paket_id) + max_size();
+		return size_varnum(static_cast<std::int32_t>(body)) + body;
+	}
 private:
 	template <typename first, typename ...other>
 	static int write_field(byte_t bytes[], std::size_t length, const first & field, const other &... fields) {
-		int s = field.write(bytes, length);
-		if (s < 0)
-			return -1;
-		int comp_size = write_field(bytes + s, length - s, fields...);
-		if (comp_size < 0)
-			return -1;
-		return s + comp_size;
+		using run = fields::static_run<first, other...>;
+		if constexpr (run::count > 1) {
+			if (length < run::size)
+				return -1;
+			int comp_size = write_run<run::count>(bytes, length, field, fields...);
+			if (comp_size < 0)
+				return -1;
+			return static_cast<int>(run::size) + comp_size;
+		} else {
+			int s = field.write(bytes, length);
+			if (s < 0)
+				return -1;
+			int comp_size = write_field(bytes + s, length - s, fields...);
+			if (comp_size < 0)
+				return -1;
+			return s + comp_size;
+		}
 	}
 	static int write_field(byte_t *, std::size_t) {
 		return 0;
 	}
+	// writes n fields of a static run at constant offsets, then the rest as usual
+	template <std::size_t n, typename first, typename ...other>
+	static int write_run(byte_t bytes[], std::size_t length, const first & field, const other &... fields) {
+		std::size_t s = field.write_unchecked(bytes);
+		if constexpr (n > 1)
+			return write_run<n - 1>(bytes + s, length - s, fields...);
+		else
+			return write_field(bytes + s, length - s, fields...);
+	}
+	template <typename sink_t, typename first, typename ...other>
+	static int write_field(sink_t & sink, const first & field, const other &... fields) {
+		using run = fields::static_run<first, other...>;
+		if constexpr (run::count > 1) {
+			byte_t * bytes = sink.reserve(run::size);
+			if (bytes == nullptr)
+				return -1;
+			int comp_size = write_run<run::count>(sink, bytes, run::size, field, fields...);
+			if (comp_size < 0)
+				return -1;
+			return static_cast<int>(run::size) + comp_size;
+		} else {
+			int s = field.write(sink);
+			if (s < 0)
+				return -1;
+			int comp_size = write_field(sink, fields...);
+			if (comp_size < 0)
+				return -1;
+			return s + comp_size;
+		}
+	}
+	template <typename sink_t>
+	static int write_field(sink_t &) {
+		return 0;
+	}
+	// fills the reserved block with n fields, commits it and writes the rest
+	template <std::size_t n, typename sink_t, typename first, typename ...other>
+	static int write_run(sink_t & sink, byte_t bytes[], std::size_t size, const first & field, const other &... fields) {
+		std::size_t s = field.write_unchecked(bytes);
+		if constexpr (n > 1) {
+			return write_run<n - 1>(sink, bytes + s, size, fields...);
+		} else {
+			sink.commit(size);
+			return write_field(sink, fields...);
+		}
+	}
+	// reads fields starting at offset, on error offset points to the failed field
 	template <typename first, typename ...other>
-	static int read_field(const byte_t bytes[], std::size_t length, first & field, other &... fields) {
-		int s = field.read(bytes, length);
-		if (s < 0)
-			return -1;
-		int comp_size = read_field(bytes + s, length - s, fields...);
-		if (comp_size < 0)
-			return -1;
-		return s + comp_size;
+	static int try_read_field(const byte_t bytes[], std::size_t length, std::size_t & offset, first & field, other &... fields) {
+		using run = fields::static_run<first, other...>;
+		if constexpr (run::count > 1) {
+			if (length - offset < run::size)
+				return -1;
+			return read_run<run::count>(bytes, length, offset, field, fields...);
+		} else {
+			int s = field.try_read(bytes + offset, length - offset);
+			if (s < 0)
+				return s;
+			offset += s;
+			return try_read_field(bytes, length, offset, fields...);
+		}
 	}
-	static int read_field(const byte_t *, std::size_t) {
+	static int try_read_field(const byte_t *, std::size_t, std::size_t &) {
 		return 0;
 	}
+	// reads n fields of a static run, then the rest as usual
+	template <std::size_t n, typename first, typename ...other>
+	static int read_run(const byte_t bytes[], std::size_t length, std::size_t & offset, first & field, other &... fields) {
+		offset += static_cast<std::size_t>(field.read_unchecked(bytes + offset));
+		if constexpr (n > 1)
+			return read_run<n - 1>(bytes, length, offset, fields...);
+		else
+			return try_read_field(bytes, length, offset, fields...);
+	}
+	// reads fields of bounded paket, there should be at least max_size() bytes
+	int read_fields_unchecked(const byte_t bytes[], std::size_t & offset) noexcept {
+		int error = 0;
+		auto read_them = [bytes, &offset, &error](auto &... e) {
+			((read_field_unchecked(e, bytes, offset, error)), ...);
+		};
+		std::apply(read_them, (std::tuple<fields_t...> &) *this);
+		return error;
+	}
+	template <typename field_t>
+	static void read_field_unchecked(field_t & field, const byte_t bytes[], std::size_t & offset, int & error) noexcept {
+		int s = field.read_unchecked(bytes + offset);
+		// no branches, the first error is not important
+		error = s < 0 ? s : error;
+		offset += s < 0 ? 0 : static_cast<std::size_t>(s);
+	}
 public:
 	int write(byte_t bytes[], std::size_t length) const {
 		// HEAD
@@ -717,57 +2431,417 @@ public:
 		int k = write_varint(size_varint(paket_id) + size(), bytes, length);
 		if (k < 0)
 			return -1;
-		// size of id
-		int s = write_varint(paket_id, bytes + k, length - k);
-		if (s < 0)
+		// ID and BODY
+		int comp_size = write_id_and_body(bytes + k, length - k);
+		if (comp_size < 0)
+			return -1;
+		else
+			return comp_size + k;
+	}
+	template <std::size_t N>
+	inline int write(std::array<byte_t, N> & bytes, std::size_t length = N) const {
+		return write(bytes.data(), length);
+	}
+	/**
+	 * Writes bounded paket checking the size of the buffer once instead of
+	 * checking it for every field. If buffer is smaller than
+	 * max_frame_size() it works as write().
+	 * 
+	 * \return count of written bytes or -1 if buffer is too small
+	 */
+	int write_unchecked(byte_t bytes[], std::size_t length) const {
+		static_assert(is_bounded(), "paket has fields of unbounded size");
+		if (length < max_frame_size())
+			return write(bytes, length);
+		auto body = static_cast<std::int32_t>(size_varnum(paket_id) + size());
+		std::size_t offset = detail::write_varnum_unchecked(body, bytes);
+		offset += detail::write_varnum_unchecked(paket_id, bytes + offset);
+		auto write_them = [bytes, &offset](auto const &... e) {
+			((offset += e.write_unchecked(bytes + offset)), ...);
+		};
+		std::apply(write_them, (const std::tuple<fields_t...> &) *this);
+		return static_cast<int>(offset);
+	}
+	template <std::size_t N>
+	inline int write_unchecked(std::array<byte_t, N> & bytes, std::size_t length = N) const {
+		return write_unchecked(bytes.data(), length);
+	}
+	/**
+	 * Appends paket to the output sink.
+	 * 
+	 * Sink is any object with two methods. `reserve(n)` returns pointer to
+	 * at least n writable bytes or nullptr if there is no space. `commit(n)`
+	 * appends n bytes written to the reserved space to the sink output.
+	 * If the sink also has `position()` and `rewind(position)`, a paket that
+	 * does not fit leaves nothing in it, otherwise a part of the frame may
+	 * stay committed.
+	 * 
+	 * \return count of written bytes or -1 if the sink has no space
+	 */
+	template <typename sink_t>
+	detail::enable_if_sink_t<sink_t> write(sink_t & sink) const {
+		auto start = detail::mark(sink);
+		// HEAD
+		constexpr std::size_t head_size = 2 * max_varnum_size<std::int32_t>();
+		byte_t * bytes = sink.reserve(head_size);
+		if (bytes == nullptr)
 			return -1;
+		int k = write_varint(size_varint(paket_id) + size(), bytes, head_size);
+		int s = write_varint(paket_id, bytes + k, head_size - k);
 		s += k;
+		sink.commit(static_cast<std::size_t>(s));
 		// BODY
-		auto write_them = [bytes, length, s](auto const &... e) -> int {
-			return write_field(bytes + s, length - s, e...);
+		auto write_them = [&sink](auto const &... e) -> int {
+			return write_field(sink, e...);
 		};
 		int comp_size = std::apply(write_them, (const std::tuple<fields_t...> &) *this);
 		if (comp_size < 0)
-			return -1;
+			return detail::rewind(sink, start);
 		else
 			return comp_size + s;
 	}
+	/**
+	 * Appends paket fields that follow the paket id to the output sink.
+	 * 
+	 * \return count of written bytes or -1 if the sink has no space
+	 */
+	template <typename sink_t>
+	detail::enable_if_sink_t<sink_t> write_body(sink_t & sink) const {
+		auto write_them = [&sink](auto const &... e) -> int {
+			return write_field(sink, e...);
+		};
+		return std::apply(write_them, (const std::tuple<fields_t...> &) *this);
+	}
+	/**
+	 * Writes paket in a single pass over its fields. Space for the frame
+	 * length is reserved before the body and filled when the body is written.
+	 * Minimal length gets the longest slot, if the paket does not fit after
+	 * it, paket is written in two passes as write() does.
+	 * 
+	 * \param encoding encoding of the frame length
+	 * \return count of written bytes or -1 if buffer is too small
+	 * \throws paket_error if frame is too big for padded length
+	 */
+	int write_once(byte_t bytes[], std::size_t length, length_encoding encoding = length_encoding::padded3) const {
+		constexpr std::size_t max_head = max_varnum_size<std::int32_t>();
+		std::size_t slot = encoding == length_encoding::minimal ? max_head : static_cast<std::size_t>(encoding);
+		bool minimal = encoding == length_encoding::minimal;
+		if (length < slot)
+			return minimal ? write(bytes, length) : -1;
+		int comp_size = write_id_and_body(bytes + slot, length - slot);
+		if (comp_size < 0)
+			return minimal ? write(bytes, length) : -1;
+		if (minimal) {
+			byte_t head[max_head];
+			int k = write_varint(comp_size, head, max_head);
+			std::memmove(bytes + k, bytes + slot, comp_size);
+			std::memcpy(bytes, head, k);
+			return k + comp_size;
+		}
+		fill_padded_length(bytes, slot, comp_size);
+		return static_cast<int>(slot) + comp_size;
+	}
 	template <std::size_t N>
-	inline int write(std::array<byte_t, N> & bytes, std::size_t length = N) const {
-		return write(bytes.data(), length);
+	inline int write_once(std::array<byte_t, N> & bytes, length_encoding encoding = length_encoding::padded3) const {
+		return write_once(bytes.data(), N, encoding);
+	}
+	/**
+	 * Appends paket to the output sink in a single pass over its fields.
+	 * 
+	 * Sink should also provide `position()` that returns count of committed
+	 * bytes and `locate(position)` that returns pointer to the committed byte
+	 * at that position. Minimal length encoding is not possible without
+	 * moving data inside the sink, so in that case it works as write(sink).
+	 * Failures leave nothing in sinks that have `rewind(position)`.
+	 * 
+	 * \see write_once(byte_t[], std::size_t, length_encoding)
+	 */
+	template <typename sink_t>
+	detail::enable_if_sink_t<sink_t> write_once(sink_t & sink, length_encoding encoding = length_encoding::padded3) const {
+		if (encoding == length_encoding::minimal)
+			return write(sink);
+		auto start = detail::mark(sink);
+		std::size_t slot = static_cast<std::size_t>(encoding);
+		if (sink.reserve(slot) == nullptr)
+			return -1;
+		sink.commit(slot);
+		auto position = sink.position();
+		fields::varint id_field = paket_id;
+		auto write_them = [&sink](auto const &... e) -> int {
+			return write_field(sink, e...);
+		};
+		int comp_size = write_field(sink, id_field);
+		if (comp_size < 0)
+			return detail::rewind(sink, start);
+		int body_size = std::apply(write_them, (const std::tuple<fields_t...> &) *this);
+		if (body_size < 0)
+			return detail::rewind(sink, start);
+		comp_size += body_size;
+		if (write_varnum_padded(comp_size, sink.locate(position - slot), slot) < 0) {
+			detail::rewind(sink, start);
+			padded_overflow(slot, comp_size);
+		}
+		return static_cast<int>(slot) + comp_size;
 	}
-	int read(const byte_t bytes[], std::size_t length) {
+private:
+	int write_id_and_body(byte_t bytes[], std::size_t length) const {
+		int s = write_varint(paket_id, bytes, length);
+		if (s < 0)
+			return -1;
+		auto write_them = [bytes, length, s](auto const &... e) -> int {
+			return write_field(bytes + s, length - s, e...);
+		};
+		int comp_size = std::apply(write_them, (const std::tuple<fields_t...> &) *this);
+		if (comp_size < 0)
+			return -1;
+		return s + comp_size;
+	}
+	[[noreturn]] static void wrong_id(const byte_t bytes[], std::size_t length) {
+		std::int32_t size;
+		std::int32_t id;
+		try_head(bytes, length, size, id);
+		detail::raise("wrong paket id (" + std::to_string(paket_id) + " expected, got " + std::to_string(id) + ")");
+	}
+	[[noreturn]] static void padded_overflow(std::size_t slot, int size) {
+		detail::raise("paket size (" + std::to_string(size) + ") does not fit in " + std::to_string(slot) + " bytes");
+	}
+	static void fill_padded_length(byte_t bytes[], std::size_t slot, int size) {
+		if (write_varnum_padded(size, bytes, slot) < 0)
+			padded_overflow(slot, size);
+	}
+public:
+	/**
+	 * Reads paket from the frame without throwing exceptions on malformed
+	 * data.
+	 * 
+	 * \return count of read bytes or the reason of failure with offset
+	 *         of the malformed data in the frame
+	 */
+	read_result try_read(const byte_t bytes[], std::size_t length) {
 		std::int32_t size;
 		std::int32_t id;
 		// HEAD
-		int k = read_varint(size, bytes, length);
+		int k = try_read_varnum(size, bytes, length);
 		if (k < 0)
+			return { static_cast<paket_errc>(k), 0 };
+		if (size < 0)
+			return { paket_errc::wrong_frame, 0 };
+		if (static_cast<std::size_t>(size) + k > length)
+			return { paket_errc::incomplete, 0 };
+		// frame is complete, so nothing may be read past its end
+		int s = try_read_varnum(id, bytes + k, size);
+		if (s < 0)
+			return { s == -1 ? paket_errc::wrong_frame : static_cast<paket_errc>(s), std::size_t(k) };
+		if (id != paket_id)
+			return { paket_errc::wrong_id, std::size_t(k) };
+		int l = k + s;
+		// BODY
+		read_result result = try_read_body(bytes + l, size - s);
+		result.offset += l;
+		if (result.error == paket_errc::incomplete)
+			result.error = paket_errc::wrong_size;
+		if (result && result.offset != std::size_t(k) + size)
+			result.error = paket_errc::wrong_size;
+		return result;
+	}
+	template <std::size_t N>
+	inline read_result try_read(const std::array<byte_t, N> & bytes, std::size_t length = N) {
+		return try_read(bytes.data(), length);
+	}
+	/**
+	 * Reads paket from the frame.
+	 * 
+	 * \return count of read bytes or -1 if frame is incomplete
+	 * \throws paket_error if frame is malformed or has other paket id
+	 */
+	int read(const byte_t bytes[], std::size_t length) {
+		read_result result = try_read(bytes, length);
+		if (result)
+			return static_cast<int>(result.offset);
+		if (result.error == paket_errc::incomplete)
 			return -1;
-		if ((std::size_t)(size + k) > length)
+		if (result.error == paket_errc::wrong_id)
+			wrong_id(bytes, length);
+		detail::raise(result.error, result.offset);
+	}
+	template <std::size_t N>
+	inline int read(const std::array<byte_t, N> & bytes, std::size_t length = N) {
+		return read(bytes.data(), length);
+	}
+	/**
+	 * Reads bounded paket from the frame. Frame head is checked as usual,
+	 * then if there are at least max_size() bytes after the paket id, fields
+	 * are decoded without checking the size of the buffer for each of them.
+	 * So a buffer with exactly one frame usually takes the checked path.
+	 * 
+	 * Unchecked decoding may look at bytes after the frame, but its result
+	 * is taken only if the fields end exactly at the frame end. Otherwise
+	 * the frame is decoded again as read() does to report the error.
+	 * 
+	 * \return count of read bytes or -1 if frame is incomplete
+	 * \throws paket_error if frame is malformed or has other paket id
+	 */
+	int read_unchecked(const byte_t bytes[], std::size_t length) {
+		static_assert(is_bounded(), "paket has fields of unbounded size");
+		std::int32_t size;
+		std::int32_t id;
+		int k = try_read_varnum(size, bytes, length);
+		if (k == -1)
+			return -1;
+		if (k < 0)
+			detail::raise(static_cast<paket_errc>(k), 0);
+		if (size < 0)
+			detail::raise(paket_errc::wrong_frame, 0);
+		if (static_cast<std::size_t>(size) + k > length)
 			return -1;
-		int s = read_varint(id, bytes + k, length - k);
+		int s = try_read_varnum(id, bytes + k, size);
 		if (s < 0)
+			detail::raise(s == -1 ? paket_errc::wrong_frame : static_cast<paket_errc>(s), k);
+		if (id != paket_id)
+			wrong_id(bytes, length);
+		std::size_t offset = static_cast<std::size_t>(k + s);
+		std::size_t end = static_cast<std::size_t>(k) + size;
+		if (length - offset < max_size())
+			return read(bytes, end);
+		int error = read_fields_unchecked(bytes, offset);
+		// fields that failed or took bytes after the frame are decoded again bounded by it
+		if (error < 0 || offset != end)
+			return read(bytes, end);
+		return static_cast<int>(end);
+	}
+	template <std::size_t N>
+	inline int read_unchecked(const std::array<byte_t, N> & bytes, std::size_t length = N) {
+		return read_unchecked(bytes.data(), length);
+	}
+	/**
+	 * Reads paket fields that follow the paket id in the frame without
+	 * throwing exceptions on malformed data.
+	 * 
+	 * \return count of read bytes or the reason of failure with offset of
+	 *         the field that failed
+	 */
+	read_result try_read_body(const byte_t bytes[], std::size_t length) {
+		std::size_t offset = 0;
+		auto read_them = [bytes, length, &offset](auto &... e) -> int {
+			return try_read_field(bytes, length, offset, e...);
+		};
+		int error = std::apply(read_them, (std::tuple<fields_t...> &) *this);
+		return { static_cast<paket_errc>(error), offset };
+	}
+	/**
+	 * Reads paket fields that follow the paket id in the frame.
+	 * 
+	 * \return count of read bytes or -1 if there is not enough data
+	 * \throws paket_error if fields are malformed
+	 */
+	int read_body(const byte_t bytes[], std::size_t length) {
+		read_result result = try_read_body(bytes, length);
+		if (result)
+			return static_cast<int>(result.offset);
+		if (result.error == paket_errc::incomplete)
 			return -1;
+		detail::raise(result.error, result.offset);
+	}
+	/**
+	 * Finds the end of paket fields that follow the paket id in the frame
+	 * without decoding them.
+	 * 
+	 * \return count of bytes in the fields or the reason of failure with
+	 *         offset of the field that failed
+	 */
+	static read_result skip_body(const byte_t bytes[], std::size_t length) noexcept {
+		std::size_t offset = 0;
+		int error = 0;
+		if constexpr (sizeof...(fields_t) != 0)
+			error = skip_field<fields_t...>(bytes, length, offset);
+		return { static_cast<paket_errc>(error), offset };
+	}
+	/**
+	 * Checks the structure of the frame without decoding paket fields,
+	 * without memory allocations and without exceptions.
+	 * 
+	 * \return size of the frame or the reason of failure with offset of
+	 *         the malformed data in the frame
+	 */
+	static read_result try_validate(const byte_t bytes[], std::size_t length) noexcept {
+		std::int32_t size;
+		std::int32_t id;
+		// HEAD
+		int k = try_read_varnum(size, bytes, length);
+		if (k < 0)
+			return { static_cast<paket_errc>(k), 0 };
+		if (size < 0)
+			return { paket_errc::wrong_frame, 0 };
+		if (static_cast<std::size_t>(size) + k > length)
+			return { paket_errc::incomplete, 0 };
+		int s = try_read_varnum(id, bytes + k, size);
+		if (s < 0)
+			return { s == -1 ? paket_errc::wrong_frame : static_cast<paket_errc>(s), std::size_t(k) };
 		if (id != paket_id)
-			throw paket_error("wrong paket id (" + std::to_string(paket_id) + " expected, got " + std::to_string(id) + ")");
+			return { paket_errc::wrong_id, std::size_t(k) };
 		int l = k + s;
 		// BODY
-		auto read_them = [bytes, length, l](auto &... e) -> int {
-			return read_field(bytes + l, length - l, e...);
-		};
-		int comp_size = std::apply(read_them, (std::tuple<fields_t...> &) *this);
-		if (comp_size < 0)
+		read_result result = skip_body(bytes + l, size - s);
+		result.offset += l;
+		if (result.error == paket_errc::incomplete)
+			result.error = paket_errc::wrong_size;
+		if (result && result.offset != std::size_t(k) + size)
+			result.error = paket_errc::wrong_size;
+		return result;
+	}
+	template <std::size_t N>
+	static inline read_result try_validate(const std::array<byte_t, N> & bytes, std::size_t length = N) noexcept {
+		return try_validate(bytes.data(), length);
+	}
+	/**
+	 * Checks the structure of the frame without decoding paket fields
+	 * and without memory allocations.
+	 * 
+	 * \return count of bytes in the frame or -1 if frame is incomplete
+	 * \throws paket_error if frame is malformed or has other paket id
+	 */
+	static int validate(const byte_t bytes[], std::size_t length) {
+		read_result result = try_validate(bytes, length);
+		if (result)
+			return static_cast<int>(result.offset);
+		if (result.error == paket_errc::incomplete)
 			return -1;
-		if (size != comp_size + s)
-			throw paket_error("wrong paket size (" + std::to_string(size) + " expected, got " + std::to_string(comp_size + s) + ")");
-		else
-			return comp_size + l;
+		detail::raise(result.error, result.offset);
 	}
 	template <std::size_t N>
-	inline int read(const std::array<byte_t, N> & bytes, std::size_t length = N) {
-		return read(bytes.data(), length);
+	static inline int validate(const std::array<byte_t, N> & bytes, std::size_t length = N) {
+		return validate(bytes.data(), length);
 	}
 private:
+	template <typename first, typename ...other>
+	static int skip_field(const byte_t bytes[], std::size_t length, std::size_t & offset) noexcept {
+		using run = fields::static_run<first, other...>;
+		if constexpr (run::count > 1) {
+			if (length - offset < run::size)
+				return -1;
+			offset += run::size;
+			return skip_after<run::count, first, other...>(bytes, length, offset);
+		} else {
+			int s = first::skip(bytes + offset, length - offset);
+			if (s < 0)
+				return s;
+			offset += s;
+			if constexpr (sizeof...(other) == 0)
+				return 0;
+			else
+				return skip_field<other...>(bytes, length, offset);
+		}
+	}
+	// skips fields that follow the first n ones
+	template <std::size_t n, typename first, typename ...other>
+	static int skip_after(const byte_t bytes[], std::size_t length, std::size_t & offset) noexcept {
+		if constexpr (n > 1)
+			return skip_after<n - 1, other...>(bytes, length, offset);
+		else if constexpr (sizeof...(other) == 0)
+			return 0;
+		else
+			return skip_field<other...>(bytes, length, offset);
+	}
 	template <typename first, typename ...other>
 	static std::string enum_next_as_string(const first & field, const other &... fields) {
 		return std::string(field) + ((", " + std::string(fields)) + ...);
@@ -0,0 +1,108 @@
+#ifndef _PAKET_BATCH_HEAD
+#define _PAKET_BATCH_HEAD
+
+#include "paket.hpp"
+#include "paket_stream.hpp"
+
+#include <functional>
+#include <memory>
+
+namespace handtruth {
+
+namespace pakets {
+
+/**
+ * Finds complete frames in a contiguous buffer of length-prefixed frames.
+ * Only frame heads are parsed, paket bodies are not decoded.
+ *
+ * \param frames found frames are appended to this vector
+ * \return count of bytes taken by complete frames
+ * \throws paket_error if frame length or paket id is malformed
+ */
+std::size_t scan_frames(const byte_t bytes[], std::size_t length, std::vector<frame> & frames);
+
+/**
+ * \brief Decodes big batches of frames on several threads.
+ *
+ * Work is split into chunks of frames. Each thread starts with its own
+ * contiguous range of chunks and, when it runs out of work, steals the
+ * upper half of the range of another thread. Threads are created once and
+ * reused for every batch. The calling thread takes part in the work too.
+ */
+class batch_decoder {
+	struct pool;
+	std::unique_ptr<pool> workers;
+	std::size_t chunk;
+
+public:
+	/**
+	 * \param threads count of threads including the calling one,
+	 *        hardware concurrency if 0
+	 * \param chunk_size count of frames in one unit of work
+	 */
+	explicit batch_decoder(std::size_t threads = 0, std::size_t chunk_size = 256);
+	batch_decoder(const batch_decoder &) = delete;
+	batch_decoder & operator=(const batch_decoder &) = delete;
+	~batch_decoder();
+
+	std::size_t threads() const noexcept;
+	std::size_t chunk_size() const noexcept {
+		return chunk;
+	}
+
+	/**
+	 * Calls task(begin, end) for consecutive ranges that cover [0, count)
+	 * on all threads and waits until all of them are done. If a task
+	 * throws, the first exception is rethrown here after all threads stop.
+	 */
+	void parallel_for(std::size_t count, const std::function<void(std::size_t, std::size_t)> & task);
+
+	/**
+	 * Decodes each frame with fun(const frame &) on all threads.
+	 * Result can't be bool, neighbour results of std::vector<bool> share
+	 * words, so threads would race on them.
+	 *
+	 * \return results in the same order as the frames
+	 */
+	template <typename result_t, typename F>
+	std::vector<result_t> decode(const frame frames[], std::size_t count, F fun) {
+		static_assert(!std::is_same_v<result_t, bool>, "results are written concurrently, std::vector<bool> is bit-packed");
+		std::vector<result_t> results(count);
+		parallel_for(count, [&results, frames, &fun](std::size_t begin, std::size_t end) {
+			for (std::size_t i = begin; i < end; ++i)
+				results[i] = fun(frames[i]);
+		});
+		return results;
+	}
+	template <typename result_t, typename F>
+	std::vector<result_t> decode(const std::vector<frame> & frames, F fun) {
+		return decode<result_t>(frames.data(), frames.size(), fun);
+	}
+
+	/**
+	 * Decodes frames that all contain the same paket type.
+	 *
+	 * \return pakets in the same order as the frames
+	 * \throws paket_error if any frame is malformed or contains other paket
+	 */
+	template <typename paket_t>
+	std::vector<paket_t> decode_all(const std::vector<frame> & frames) {
+		return decode<paket_t>(frames, [](const frame & source) {
+			paket_t result;
+			if (source.id != paket_t::static_id())
+				detail::raise("wrong paket id (" + std::to_string(paket_t::static_id()) + " expected, got " + std::to_string(source.id) + ")");
+			read_result status = result.try_read_body(source.body.data(), source.body.size());
+			if (status && status.offset != source.body.size())
+				status.error = paket_errc::wrong_size;
+			if (!status)
+				detail::raise(status.error == paket_errc::incomplete ? paket_errc::wrong_size : status.error, status.offset);
+			return result;
+		});
+	}
+};
+
+} // namespace pakets
+
+} // namespace handtruth
+
+#endif // _PAKET_BATCH_HEAD
@@ -0,0 +1,215 @@
+#ifndef _PAKET_CAPTURE_HEAD
+#define _PAKET_CAPTURE_HEAD
+
+#include "paket.hpp"
+#include "paket_stream.hpp"
+#include "paket_sink.hpp"
+
+#include <cstdio>
+#include <chrono>
+#include <thread>
+#include <memory>
+
+namespace handtruth {
+
+namespace pakets {
+
+/**
+ * \brief Direction of captured traffic.
+ */
+enum class direction : std::uint8_t {
+	inbound = 0,
+	outbound = 1
+};
+
+/**
+ * \brief One captured frame. Frame bytes point into the capture file.
+ */
+struct capture_record {
+	/// nanoseconds since the epoch
+	std::int64_t timestamp = 0;
+	std::uint32_t connection = 0;
+	pakets::direction direction = pakets::direction::inbound;
+	/// whole frame as it was sent, suitable for paket::read() and paket_view
+	frame content;
+};
+
+/**
+ * \brief Appends captured frames to a capture file and its index.
+ *
+ * Capture file starts with a 16 byte header, then records follow. Each
+ * record is a 16 byte header (little endian timestamp, connection id and
+ * direction) and the frame bytes `[length][id][body]` as they were sent.
+ * Index file `<path>.idx` has a 16 byte header and a 24 byte entry per
+ * record with timestamp, record offset, paket id and connection id, so
+ * records can be found by time or id without reading the frames.
+ *
+ * Existing files are appended to.
+ */
+class capture_writer {
+	std::FILE * data = nullptr;
+	std::FILE * index = nullptr;
+	std::uint64_t offset = 0;
+	std::uint64_t records = 0;
+	std::int64_t last_time = 0;
+	vector_sink scratch;
+
+public:
+	/**
+	 * \throws paket_error if files can't be opened or are not capture files
+	 */
+	explicit capture_writer(const std::string & path);
+	capture_writer(const capture_writer &) = delete;
+	capture_writer & operator=(const capture_writer &) = delete;
+	~capture_writer();
+
+	/**
+	 * Appends the frame. Timestamps are expected to not decrease, smaller
+	 * timestamp is replaced with the last one to keep the index ordered.
+	 *
+	 * \param bytes whole frame including length prefix
+	 * \throws paket_error if bytes are not exactly one frame or write fails
+	 */
+	void record(const byte_t bytes[], std::size_t length, pakets::direction dir, std::uint32_t connection, std::int64_t timestamp);
+	void record(const byte_t bytes[], std::size_t length, pakets::direction dir, std::uint32_t connection = 0) {
+		record(bytes, length, dir, connection, now());
+	}
+	void record(const frame & source, pakets::direction dir, std::uint32_t connection = 0) {
+		record(source.data.data(), source.data.size(), dir, connection, now());
+	}
+	template <typename paket_t>
+	void record(const paket_t & source, pakets::direction dir, std::uint32_t connection, std::int64_t timestamp) {
+		scratch.clear();
+		if (source.write(scratch) < 0)
+			detail::raise("failed to encode paket for capture");
+		record(scratch.data(), scratch.size(), dir, connection, timestamp);
+	}
+	template <typename paket_t>
+	void record(const paket_t & source, pakets::direction dir, std::uint32_t connection = 0) {
+		record(source, dir, connection, now());
+	}
+
+	/// count of records in the capture including the ones written before
+	std::uint64_t size() const noexcept {
+		return records;
+	}
+	/// writes buffered records to both files
+	void flush();
+
+	/// current time in capture timestamps
+	static std::int64_t now() noexcept {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	}
+};
+
+/**
+ * \brief Read-only access to a capture file.
+ *
+ * Capture is mapped into memory when mmap is available and read into a
+ * buffer otherwise. Frames of records are not copied. Index file is used
+ * if it matches the capture, otherwise index is rebuilt in memory by
+ * scanning the records, so captures of crashed writers are still readable.
+ * An incomplete record at the end of the capture is ignored.
+ */
+class capture_reader {
+	struct storage;
+	std::unique_ptr<storage> files;
+	const byte_t * index_entries = nullptr;
+	std::size_t count = 0;
+
+	capture_record at(std::size_t i) const;
+
+public:
+	/**
+	 * \throws paket_error if capture can't be read or is corrupted
+	 */
+	explicit capture_reader(const std::string & path);
+	capture_reader(capture_reader &&) noexcept;
+	capture_reader & operator=(capture_reader &&) noexcept;
+	~capture_reader();
+
+	std::size_t size() const noexcept {
+		return count;
+	}
+	bool empty() const noexcept {
+		return count == 0;
+	}
+	capture_record operator[](std::size_t i) const {
+		return at(i);
+	}
+
+	/// timestamp of the record without touching the capture file
+	std::int64_t timestamp(std::size_t i) const noexcept;
+	/// paket id of the record without touching the capture file
+	std::int32_t id(std::size_t i) const noexcept;
+	/// connection id of the record without touching the capture file
+	std::uint32_t connection(std::size_t i) const noexcept;
+
+	/**
+	 * \return index of the first record with timestamp not less than time
+	 *         or size() if there is no such record
+	 */
+	std::size_t lower_bound(std::int64_t time) const noexcept;
+	/**
+	 * Looks up the paket id in the map that is built once when the
+	 * capture is opened.
+	 *
+	 * \return indices of records with the paket id in capture order
+	 */
+	const std::vector<std::size_t> & find(std::int32_t id) const;
+
+	class iterator {
+		const capture_reader * reader;
+		std::size_t i;
+	public:
+		iterator(const capture_reader * reader, std::size_t i) noexcept : reader(reader), i(i) {}
+		capture_record operator*() const {
+			return reader->at(i);
+		}
+		iterator & operator++() noexcept {
+			++i;
+			return *this;
+		}
+		bool operator==(const iterator & other) const noexcept {
+			return i == other.i;
+		}
+		bool operator!=(const iterator & other) const noexcept {
+			return i != other.i;
+		}
+	};
+	iterator begin() const noexcept {
+		return iterator(this, 0);
+	}
+	iterator end() const noexcept {
+		return iterator(this, count);
+	}
+
+	/**
+	 * Calls fun(const capture_record &) for records in [first, last),
+	 * keeping the time intervals between them.
+	 *
+	 * \param speed replay speed factor, records are not delayed if 0
+	 */
+	template <typename F>
+	void replay(F fun, double speed = 1.0, std::size_t first = 0, std::size_t last = std::size_t(-1)) const {
+		if (last > count)
+			last = count;
+		if (first >= last)
+			return;
+		auto start = std::chrono::steady_clock::now();
+		std::int64_t origin = timestamp(first);
+		for (std::size_t i = first; i < last; ++i) {
+			if (speed > 0) {
+				auto delay = std::chrono::nanoseconds(static_cast<std::int64_t>((timestamp(i) - origin) / speed));
+				std::this_thread::sleep_until(start + delay);
+			}
+			fun(at(i));
+		}
+	}
+};
+
+} // namespace pakets
+
+} // namespace handtruth
+
+#endif // _PAKET_CAPTURE_HEAD
@@ -0,0 +1,415 @@
+#ifndef _PAKET_DECODER_HEAD
+#define _PAKET_DECODER_HEAD
+
+#include "paket.hpp"
+
+#include <functional>
+#include <algorithm>
+
+namespace handtruth {
+
+namespace pakets {
+
+namespace detail {
+
+template <typename T> struct is_string_field : std::false_type {};
+template <> struct is_string_field<fields::string> : std::true_type {};
+template <> struct is_string_field<fields::pmr::string> : std::true_type {};
+template <> struct is_string_field<fields::string_view> : std::true_type {};
+
+template <typename T> struct is_rest_field : std::false_type {};
+template <> struct is_rest_field<fields::rest> : std::true_type {};
+template <> struct is_rest_field<fields::pmr::rest> : std::true_type {};
+template <> struct is_rest_field<fields::bytes_view> : std::true_type {};
+
+template <typename T, typename = void>
+struct is_list_field : std::false_type {};
+template <typename T>
+struct is_list_field<T, std::void_t<typename T::list_element>>
+	: std::is_base_of<fields::basic_list<typename T::list_element, typename T::value_type>, T> {};
+
+// field or its list elements would refer to the bytes that are gone after feed() returns
+template <typename T, bool = is_list_field<T>::value>
+struct refers_to_source : fields::is_source_view<T> {};
+template <typename T>
+struct refers_to_source<T, true> : refers_to_source<typename T::list_element> {};
+
+} // namespace detail
+
+/**
+ * \brief Resumable decoder of a single frame that comes in chunks.
+ *
+ * Unlike paket::read() it does not need the whole frame in one buffer.
+ * Fields are decoded as soon as their bytes arrive, list elements one by
+ * one. Contents of rest and of strings longer than the window are passed
+ * to the chunk handler as they arrive instead of being stored, so memory
+ * of the decoder is bounded by the window and not by the frame size.
+ *
+ * Every other field and list element should fit in the window. View
+ * fields string_view and bytes_view are always left empty and their
+ * contents go to the handler. Other fields that refer to the decoded
+ * buffer, like NBT or lists of views, are rejected at compile time.
+ */
+template <typename paket_t>
+class paket_decoder {
+public:
+	/**
+	 * Receives the next part of the streamed field contents.
+	 *
+	 * \param field index of the field in the paket
+	 * \param chunk bytes that are valid only during the call
+	 */
+	typedef std::function<void(std::size_t field, byte_span chunk)> chunk_handler;
+
+	/// enough for a chunk section with 15 bits per block
+	static constexpr std::size_t default_window_size = 16384;
+
+private:
+	enum class stage : std::uint8_t {
+		length, id, field, content, done, failed
+	};
+
+	paket_t result;
+	chunk_handler handler;
+	// bytes of the field that did not arrive completely yet
+	std::vector<byte_t> carry;
+	std::size_t window;
+	const byte_t * input = nullptr;
+	std::size_t input_left = 0;
+	// bytes of the frame consumed so far, including the length prefix
+	std::size_t position = 0;
+	std::size_t frame_end = 0;
+	std::size_t unit_start = 0;
+	std::size_t field_index = 0;
+	// bytes of the string or elements of the list that are not decoded yet
+	std::size_t left = 0;
+	read_result failure;
+	stage state = stage::length;
+	bool streaming = false;
+	bool element_open = false;
+
+	void advance(std::size_t size) noexcept {
+		input += size;
+		input_left -= size;
+		position += size;
+	}
+
+	int fail_at(paket_errc error, std::size_t offset) noexcept {
+		unit_start = offset;
+		return static_cast<int>(error);
+	}
+
+	/**
+	 * Decodes a unit that has to be contiguous: a varnum or a whole field.
+	 * Bytes of the incomplete unit are kept in the carry buffer.
+	 *
+	 * \return 1 if the unit is decoded, 0 if more data is required or a
+	 *         negative paket_errc value
+	 */
+	template <typename parse_t>
+	int take(parse_t && parse) {
+		unit_start = position - carry.size();
+		std::size_t limit = input_left;
+		if (state != stage::length)
+			limit = std::min(limit, frame_end - position);
+		if (carry.empty()) {
+			int s = parse(input, limit);
+			if (s >= 0) {
+				advance(static_cast<std::size_t>(s));
+				return 1;
+			}
+			if (s != -1)
+				return s;
+			if (limit > window)
+				return static_cast<int>(paket_errc::budget_exceeded);
+			carry.assign(input, input + limit);
+			advance(limit);
+		} else if (limit != 0) {
+			std::size_t kept = carry.size();
+			std::size_t n = std::min(limit, window - kept);
+			carry.insert(carry.end(), input, input + n);
+			int s = parse(carry.data(), carry.size());
+			if (s >= 0) {
+				// bytes after the unit are given back to the input
+				carry.clear();
+				advance(static_cast<std::size_t>(s) - kept);
+				return 1;
+			}
+			if (s != -1)
+				return s;
+			advance(n);
+		}
+		if (carry.size() >= window)
+			return static_cast<int>(paket_errc::budget_exceeded);
+		if (state != stage::length && position == frame_end)
+			return static_cast<int>(paket_errc::wrong_size);
+		return 0;
+	}
+
+	template <std::size_t i, typename field_t>
+	bool deliver(field_t & field, std::size_t size) {
+		if (streaming) {
+			if (handler)
+				handler(i, byte_span(input, size));
+		} else if constexpr (!fields::is_source_view<field_t>::value) {
+			if (!memory_budget::charge(size))
+				return false;
+			if constexpr (detail::is_string_field<field_t>::value)
+				field.value.append(reinterpret_cast<const char *>(input), size);
+			else
+				field.value.insert(field.value.end(), input, input + size);
+		}
+		advance(size);
+		return true;
+	}
+
+	template <typename field_t>
+	static void clear(field_t & field) noexcept {
+		if constexpr (fields::is_source_view<field_t>::value)
+			field.value = {};
+		else
+			field.value.clear();
+	}
+
+	int enter_field() noexcept {
+		state = stage::field;
+		if (field_index != paket_t::fields_count())
+			return 1;
+		if (position != frame_end)
+			return fail_at(paket_errc::wrong_size, position);
+		state = stage::done;
+		return 1;
+	}
+
+	int next_field() noexcept {
+		++field_index;
+		return enter_field();
+	}
+
+	template <std::size_t i>
+	int step_field() {
+		using field_t = typename paket_t::template field_type<i>;
+		static_assert(!detail::refers_to_source<field_t>::value || detail::is_string_field<field_t>::value
+			|| detail::is_rest_field<field_t>::value, "field would refer to bytes that do not outlive feed()");
+		field_t & field = result.template wrapper<i>();
+		if constexpr (detail::is_rest_field<field_t>::value) {
+			if (state == stage::field) {
+				clear(field);
+				streaming = fields::is_source_view<field_t>::value || handler;
+				state = stage::content;
+			}
+			std::size_t n = std::min(input_left, frame_end - position);
+			if (n != 0 && !deliver<i>(field, n))
+				return fail_at(paket_errc::budget_exceeded, position);
+			return position == frame_end ? next_field() : 0;
+		} else if constexpr (detail::is_string_field<field_t>::value) {
+			if (state == stage::field) {
+				std::int32_t length = 0;
+				int r = take([&length](const byte_t bytes[], std::size_t size) {
+					return try_read_varnum(length, bytes, size);
+				});
+				if (r <= 0)
+					return r;
+				if (length < 0)
+					return static_cast<int>(paket_errc::negative_length);
+				left = static_cast<std::size_t>(length);
+				if (left > frame_end - position)
+					return static_cast<int>(paket_errc::wrong_size);
+				clear(field);
+				streaming = fields::is_source_view<field_t>::value || (handler && left > window);
+				state = stage::content;
+			}
+			std::size_t n = std::min(input_left, left);
+			if (n != 0 && !deliver<i>(field, n))
+				return fail_at(paket_errc::budget_exceeded, position);
+			left -= n;
+			return left == 0 ? next_field() : 0;
+		} else if constexpr (detail::is_list_field<field_t>::value) {
+			using element_t = typename field_t::list_element;
+			if (state == stage::field) {
+				std::int32_t count = 0;
+				int r = take([&count](const byte_t bytes[], std::size_t size) {
+					return try_read_varnum(count, bytes, size);
+				});
+				if (r <= 0)
+					return r;
+				if (count < 0)
+					return static_cast<int>(paket_errc::negative_length);
+				left = static_cast<std::size_t>(count);
+				if constexpr (element_t::min_size() != 0) {
+					if (left > (frame_end - position) / element_t::min_size())
+						return static_cast<int>(paket_errc::wrong_size);
+				}
+				field.value.clear();
+				element_open = false;
+				state = stage::content;
+			}
+			while (left != 0) {
+				if (!element_open) {
+					if (!memory_budget::charge(sizeof(element_t)))
+						return fail_at(paket_errc::budget_exceeded, position);
+					field.value.emplace_back();
+					element_open = true;
+				}
+				element_t & element = field.value.back();
+				int r = take([&element](const byte_t bytes[], std::size_t size) {
+					return element.try_read(bytes, size);
+				});
+				if (r <= 0)
+					return r;
+				element_open = false;
+				--left;
+			}
+			return next_field();
+		} else {
+			int r = take([&field](const byte_t bytes[], std::size_t size) {
+				return field.try_read(bytes, size);
+			});
+			if (r <= 0)
+				return r;
+			return next_field();
+		}
+	}
+
+	template <std::size_t ...i>
+	int step_field(std::index_sequence<i...>) {
+		int r = 0;
+		((field_index == i && (r = step_field<i>(), true)) || ...);
+		return r;
+	}
+
+	int step() {
+		switch (state) {
+		case stage::length: {
+			std::int32_t size = 0;
+			int r = take([&size](const byte_t bytes[], std::size_t length) {
+				return try_read_varnum(size, bytes, length);
+			});
+			if (r <= 0)
+				return r;
+			if (size < 0)
+				return fail_at(paket_errc::wrong_frame, 0);
+			frame_end = position + static_cast<std::size_t>(size);
+			state = stage::id;
+			return 1;
+		}
+		case stage::id: {
+			std::int32_t id = 0;
+			int r = take([&id](const byte_t bytes[], std::size_t length) {
+				return try_read_varnum(id, bytes, length);
+			});
+			if (r == static_cast<int>(paket_errc::wrong_size))
+				return static_cast<int>(paket_errc::wrong_frame);
+			if (r <= 0)
+				return r;
+			if (id != paket_t::static_id())
+				return static_cast<int>(paket_errc::wrong_id);
+			field_index = 0;
+			return enter_field();
+		}
+		case stage::field:
+		case stage::content:
+			return step_field(std::make_index_sequence<paket_t::fields_count()>());
+		default:
+			return 0;
+		}
+	}
+
+public:
+	/**
+	 * \param on_chunk receives contents of rest and long strings, if it is
+	 *        empty they are stored in the paket as usual
+	 * \param window_size greatest size of a field that is decoded from
+	 *        the internal buffer when it arrives in several chunks
+	 */
+	explicit paket_decoder(chunk_handler on_chunk = {}, std::size_t window_size = default_window_size)
+		: handler(std::move(on_chunk)), window(window_size) {}
+
+	/**
+	 * Decodes the next part of the frame without throwing exceptions on
+	 * malformed data. Bytes after the end of the frame are not consumed.
+	 *
+	 * \return count of consumed bytes or the reason of failure with offset
+	 *         of the malformed data in the frame, the same failure is
+	 *         returned until reset()
+	 */
+	read_result try_feed(const byte_t bytes[], std::size_t length) {
+		if (state == stage::failed)
+			return failure;
+		input = bytes;
+		input_left = length;
+		while (state != stage::done) {
+			int r = step();
+			if (r < 0) {
+				state = stage::failed;
+				failure = { static_cast<paket_errc>(r), unit_start };
+				carry.clear();
+				return failure;
+			}
+			if (r == 0)
+				break;
+		}
+		std::size_t consumed = length - input_left;
+		input = nullptr;
+		input_left = 0;
+		return { paket_errc::ok, consumed };
+	}
+
+	/**
+	 * Decodes the next part of the frame.
+	 *
+	 * \return count of consumed bytes, less than length only if the frame
+	 *         is complete
+	 * \throws paket_error if frame is malformed or has other paket id
+	 */
+	std::size_t feed(const byte_t bytes[], std::size_t length) {
+		read_result r = try_feed(bytes, length);
+		if (!r)
+			detail::raise(r.error, r.offset);
+		return r.offset;
+	}
+
+	/// whether the whole frame is decoded
+	bool done() const noexcept {
+		return state == stage::done;
+	}
+
+	/// decoded paket, fields after the current one are not decoded yet
+	paket_t & get() noexcept {
+		return result;
+	}
+	const paket_t & get() const noexcept {
+		return result;
+	}
+
+	/// count of consumed bytes of the frame
+	std::size_t consumed() const noexcept {
+		return position;
+	}
+
+	/// count of bytes left in the frame, 0 if the frame length is not known yet
+	std::size_t expected() const noexcept {
+		return state == stage::length ? 0 : frame_end - position;
+	}
+
+	/// count of bytes of the incomplete field, never greater than the window
+	std::size_t buffered() const noexcept {
+		return carry.size();
+	}
+
+	/// prepares the decoder for the next frame
+	void reset() {
+		result = paket_t();
+		carry.clear();
+		position = frame_end = unit_start = field_index = left = 0;
+		failure = {};
+		state = stage::length;
+		streaming = element_open = false;
+	}
+};
+
+} // namespace pakets
+
+} // namespace handtruth
+
+#endif // _PAKET_DECODER_HEAD
@@ -0,0 +1,191 @@
+#ifndef _PAKET_DISPATCHER_HEAD
+#define _PAKET_DISPATCHER_HEAD
+
+#include "paket.hpp"
+#include "paket_stream.hpp"
+
+#include <utility>
+
+namespace handtruth {
+
+namespace pakets {
+
+/**
+ * \brief Decodes frames into one of the specified paket types by paket id.
+ * 
+ * Lookup table from paket id to paket type is built at compile time. If ids
+ * are dense it is a plain array indexed by id, otherwise it is a sorted array
+ * of ids. The frame head is parsed once and the paket body is decoded
+ * directly into the matching paket which is passed to the visitor.
+ * 
+ * Visitor is called with the decoded paket. If the visitor is also
+ * invocable with paket id and body bytes, it is called this way for
+ * unknown paket ids, otherwise paket_error is thrown.
+ */
+template <typename ...pakets_t>
+class paket_dispatcher {
+	static_assert(sizeof...(pakets_t) > 0, "dispatcher requires at least one paket type");
+
+	static constexpr std::size_t count = sizeof...(pakets_t);
+	static constexpr std::array<std::int32_t, count> ids { pakets_t::static_id()... };
+
+	static constexpr bool unique_ids() noexcept {
+		for (std::size_t i = 0; i < count; ++i)
+			for (std::size_t j = i + 1; j < count; ++j)
+				if (ids[i] == ids[j])
+					return false;
+		return true;
+	}
+	static_assert(unique_ids(), "paket ids in dispatcher must be unique");
+
+	static constexpr std::int32_t min_id() noexcept {
+		std::int32_t result = ids[0];
+		for (auto id : ids)
+			result = id < result ? id : result;
+		return result;
+	}
+	static constexpr std::int32_t max_id() noexcept {
+		std::int32_t result = ids[0];
+		for (auto id : ids)
+			result = id > result ? id : result;
+		return result;
+	}
+
+	static constexpr std::uint64_t range = std::uint64_t(std::int64_t(max_id()) - min_id()) + 1;
+	static constexpr bool dense = range <= 4 * count + 64;
+
+	typedef std::conditional_t<(count < 0xff), std::uint8_t, std::uint16_t> index_t;
+	static constexpr std::size_t table_size = dense ? static_cast<std::size_t>(range) : count;
+
+	// dense: index by (id - min_id); sparse: indices of ids in ascending order of ids
+	static constexpr std::array<index_t, table_size> make_table() noexcept {
+		std::array<index_t, table_size> table {};
+		if constexpr (dense) {
+			for (auto & each : table)
+				each = static_cast<index_t>(count);
+			for (std::size_t i = 0; i < count; ++i)
+				table[ids[i] - min_id()] = static_cast<index_t>(i);
+		} else {
+			for (std::size_t i = 0; i < count; ++i)
+				table[i] = static_cast<index_t>(i);
+			for (std::size_t i = 1; i < count; ++i)
+				for (std::size_t j = i; j > 0 && ids[table[j - 1]] > ids[table[j]]; --j) {
+					index_t tmp = table[j];
+					table[j] = table[j - 1];
+					table[j - 1] = tmp;
+				}
+		}
+		return table;
+	}
+	static constexpr std::array<index_t, table_size> table = make_table();
+
+	template <typename visitor_t>
+	using handler_t = void (*)(const byte_t[], std::size_t, visitor_t &);
+
+	template <typename visitor_t, std::size_t i>
+	static void handle(const byte_t bytes[], std::size_t length, visitor_t & visitor) {
+		std::tuple_element_t<i, std::tuple<pakets_t...>> result;
+		int s = result.read_body(bytes, length);
+		if (s < 0 || static_cast<std::size_t>(s) != length)
+			detail::raise("wrong paket size (" + std::to_string(length) + " bytes of paket body expected, got "
+				+ (s < 0 ? std::string("more") : std::to_string(s)) + ")");
+		visitor(result);
+	}
+
+	template <typename visitor_t, std::size_t ...i>
+	static constexpr std::array<handler_t<visitor_t>, count> make_handlers(std::index_sequence<i...>) noexcept {
+		return { &handle<visitor_t, i>... };
+	}
+
+	template <typename visitor_t>
+	static constexpr std::array<handler_t<visitor_t>, count> handlers = make_handlers<visitor_t>(std::index_sequence_for<pakets_t...>());
+
+public:
+	/**
+	 * Finds position of paket type with the specified id.
+	 * 
+	 * \return index of paket type in the parameter list or count of paket types if there is no such id
+	 */
+	static constexpr std::size_t index_of(std::int32_t id) noexcept {
+		if constexpr (dense) {
+			std::int64_t pos = std::int64_t(id) - min_id();
+			if (pos < 0 || static_cast<std::uint64_t>(pos) >= range)
+				return count;
+			return table[static_cast<std::size_t>(pos)];
+		} else {
+			std::size_t low = 0, high = count;
+			while (low < high) {
+				std::size_t middle = (low + high) / 2;
+				if (ids[table[middle]] < id)
+					low = middle + 1;
+				else
+					high = middle;
+			}
+			return low < count && ids[table[low]] == id ? table[low] : count;
+		}
+	}
+
+	static constexpr bool contains(std::int32_t id) noexcept {
+		return index_of(id) != count;
+	}
+
+	/**
+	 * Decodes paket body and passes the paket to the visitor.
+	 * 
+	 * \param id paket id from the frame head
+	 * \param body bytes of the frame after the paket id
+	 * \throws paket_error if paket is malformed or id is unknown
+	 */
+	template <typename visitor_t>
+	static void dispatch(std::int32_t id, const byte_t body[], std::size_t length, visitor_t && visitor) {
+		std::size_t index = index_of(id);
+		if (index != count) {
+			handlers<std::remove_reference_t<visitor_t>>[index](body, length, visitor);
+		} else if constexpr (std::is_invocable_v<visitor_t &, std::int32_t, byte_span>) {
+			visitor(id, byte_span(body, length));
+		} else {
+			detail::raise("unknown paket id (" + std::to_string(id) + ")");
+		}
+	}
+
+	/**
+	 * Decodes the frame and passes the paket to the visitor.
+	 * 
+	 * \return count of bytes in the frame or -1 if frame is incomplete
+	 * \throws paket_error if frame or paket is malformed or id is unknown
+	 */
+	template <typename visitor_t>
+	static int dispatch(const byte_t bytes[], std::size_t length, visitor_t && visitor) {
+		std::int32_t size;
+		std::int32_t id;
+		int k = read_varint(size, bytes, length);
+		if (k < 0)
+			return -1;
+		// waiting for more data would not fix the negative length
+		if (size < 0)
+			detail::raise(paket_errc::wrong_frame, 0);
+		if (static_cast<std::size_t>(size) + k > length)
+			return -1;
+		int s = read_varint(id, bytes + k, size);
+		if (s < 0)
+			detail::raise(paket_errc::wrong_frame, k);
+		dispatch(id, bytes + k + s, size - s, visitor);
+		return k + size;
+	}
+
+	/**
+	 * Decodes the frame taken from paket_stream and passes the paket to the visitor.
+	 * 
+	 * \throws paket_error if paket is malformed or id is unknown
+	 */
+	template <typename visitor_t>
+	static void dispatch(const frame & source, visitor_t && visitor) {
+		dispatch(source.id, source.body.data(), source.body.size(), visitor);
+	}
+};
+
+} // namespace pakets
+
+} // namespace handtruth
+
+#endif // _PAKET_DISPATCHER_HEAD
@@ -0,0 +1,255 @@
+#ifndef _PAKET_NBT_HEAD
+#define _PAKET_NBT_HEAD
+
+#include "paket.hpp"
+
+#include <iterator>
+#include <string_view>
+
+namespace handtruth {
+
+namespace pakets {
+
+/// type of NBT tag as it is encoded
+enum class nbt_tag : std::uint8_t {
+	end = 0,
+	byte = 1,
+	int16 = 2,
+	int32 = 3,
+	int64 = 4,
+	float32 = 5,
+	float64 = 6,
+	byte_array = 7,
+	string = 8,
+	list = 9,
+	compound = 10,
+	int_array = 11,
+	long_array = 12,
+};
+
+/// deepest nesting of lists and compounds accepted like in vanilla Minecraft
+constexpr int nbt_max_depth = 512;
+
+/**
+ * \brief Read-only view of an NBT tag that decodes values on demand.
+ *
+ * View refers to bytes of the validated tag and does not own them. It
+ * never allocates: lookups in compounds and lists skip over the
+ * preceding entries. Missing entries and elements are empty views, so
+ * lookups can be chained like `root["Item"]["tag"]["Damage"]`.
+ */
+class nbt_view {
+	const byte_t * bytes = nullptr;
+	std::size_t length = 0;
+	nbt_tag tag = nbt_tag::end;
+	std::string_view tag_name;
+
+	template <typename T>
+	T number(nbt_tag expected) const;
+	const byte_t * element(std::size_t index, nbt_tag & type, std::size_t & size) const noexcept;
+public:
+	class iterator;
+
+	nbt_view() noexcept = default;
+	/**
+	 * \param type type of the tag
+	 * \param payload validated payload of the tag
+	 * \param size size of the payload
+	 * \param name name of the tag in the compound or of the root tag
+	 */
+	constexpr nbt_view(nbt_tag type, const byte_t payload[], std::size_t size, std::string_view name = {}) noexcept
+		: bytes(payload), length(size), tag(type), tag_name(name) {}
+
+	constexpr nbt_tag type() const noexcept {
+		return tag;
+	}
+	constexpr std::string_view name() const noexcept {
+		return tag_name;
+	}
+	/// view is empty if the tag is missing or is TAG_End
+	constexpr bool empty() const noexcept {
+		return tag == nbt_tag::end;
+	}
+	explicit constexpr operator bool() const noexcept {
+		return !empty();
+	}
+	/// encoded value of the tag without type and name
+	constexpr byte_span payload() const noexcept {
+		return byte_span(bytes, length);
+	}
+
+	/// \throws paket_error if the tag has other type
+	std::int8_t as_byte() const;
+	std::int16_t as_int16() const;
+	std::int32_t as_int32() const;
+	std::int64_t as_int64() const;
+	float as_float32() const;
+	double as_float64() const;
+	/// characters in Java modified UTF-8
+	std::string_view as_string() const;
+	/// bytes of TAG_Byte_Array
+	byte_span as_bytes() const;
+
+	/// type of list elements, byte, int32 or int64 for arrays
+	nbt_tag element_type() const noexcept;
+	/**
+	 * \return count of elements in list or array, count of entries in
+	 *         compound, or 0 for other tags
+	 */
+	std::size_t size() const noexcept;
+	/// element of list or array, empty view if there is no such element
+	nbt_view operator[](std::size_t index) const noexcept;
+	// literal 0 would be ambiguous with the name
+	nbt_view operator[](int index) const noexcept {
+		return index < 0 ? nbt_view() : (*this)[static_cast<std::size_t>(index)];
+	}
+	/// entry of compound, empty view if there is no such entry
+	nbt_view operator[](std::string_view name) const noexcept;
+	nbt_view operator[](const char * name) const noexcept {
+		return (*this)[std::string_view(name)];
+	}
+
+	/// iterates elements of list or array, or entries of compound
+	iterator begin() const noexcept;
+	iterator end() const noexcept;
+
+	/**
+	 * \param named whether the root tag has a name, it does not since
+	 *        Minecraft 1.20.2 in the network protocol
+	 * \return size of the tag encoded as the root tag
+	 */
+	std::size_t encoded_size(bool named) const noexcept;
+
+	/// string notation of the tag, like `{Count:3b,id:"minecraft:stone"}`
+	std::string to_string() const;
+
+	/// tags are equal if they have the same type, name and payload bytes
+	friend bool operator==(const nbt_view & lhs, const nbt_view & rhs) noexcept;
+	friend bool operator!=(const nbt_view & lhs, const nbt_view & rhs) noexcept {
+		return !(lhs == rhs);
+	}
+};
+
+class nbt_view::iterator {
+	const byte_t * position = nullptr;
+	const byte_t * last = nullptr;
+	nbt_tag container = nbt_tag::end;
+	nbt_tag element = nbt_tag::end;
+	nbt_view current;
+
+	void load() noexcept;
+	friend class nbt_view;
+public:
+	typedef std::forward_iterator_tag iterator_category;
+	typedef nbt_view value_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef const nbt_view * pointer;
+	typedef const nbt_view & reference;
+
+	iterator() noexcept = default;
+
+	const nbt_view & operator*() const noexcept {
+		return current;
+	}
+	const nbt_view * operator->() const noexcept {
+		return &current;
+	}
+	iterator & operator++() noexcept {
+		position = current.bytes + current.length;
+		load();
+		return *this;
+	}
+	iterator operator++(int) noexcept {
+		iterator result = *this;
+		++*this;
+		return result;
+	}
+	bool operator==(const iterator & other) const noexcept {
+		return position == other.position;
+	}
+	bool operator!=(const iterator & other) const noexcept {
+		return position != other.position;
+	}
+};
+
+/**
+ * Finds the end of the tag payload and checks its structure.
+ *
+ * \return size of the payload, -1 if there is not enough data or a
+ *         negative paket_errc value
+ */
+int skip_nbt_payload(nbt_tag type, const byte_t bytes[], std::size_t length) noexcept;
+
+/**
+ * Checks the root NBT tag and makes view of it. Single TAG_End is
+ * accepted and gives empty view, Minecraft uses it for missing NBT.
+ *
+ * \param named whether the root tag has a name
+ * \return size of the tag, -1 if there is not enough data or a negative
+ *         paket_errc value
+ */
+int try_read_nbt(nbt_view & view, const byte_t bytes[], std::size_t length, bool named) noexcept;
+
+/**
+ * Writes the tag as the root tag, payload is copied as is.
+ *
+ * \return count of written bytes or -1 if buffer is too small
+ */
+int write_nbt(const nbt_view & view, byte_t bytes[], std::size_t length, bool named) noexcept;
+
+namespace fields {
+
+	/**
+	 * \brief NBT tag that is validated on read but not decoded.
+	 *
+	 * Value is nbt_view that refers to the decoded buffer, so it stays
+	 * valid as long as the source buffer does. Unchanged NBT is written
+	 * back with a single copy of its payload.
+	 */
+	template <bool named>
+	struct basic_nbt : public field<nbt_view> {
+		basic_nbt() = default;
+		constexpr basic_nbt(const value_type & init) : field(init) {}
+		std::size_t size() const noexcept {
+			return value.encoded_size(named);
+		}
+		int try_read(const byte_t bytes[], std::size_t length) noexcept {
+			return try_read_nbt(value, bytes, length, named);
+		}
+		int read(const byte_t bytes[], std::size_t length) {
+			return detail::checked(try_read(bytes, length));
+		}
+		int write(byte_t bytes[], std::size_t length) const noexcept {
+			return write_nbt(value, bytes, length, named);
+		}
+		static constexpr std::size_t min_size() noexcept {
+			return 1;
+		}
+		static int skip(const byte_t bytes[], std::size_t length) noexcept {
+			nbt_view view;
+			return try_read_nbt(view, bytes, length, named);
+		}
+		template <typename sink_t>
+		detail::enable_if_sink_t<sink_t> write(sink_t & sink) const {
+			return detail::write_reserved(sink, *this, size());
+		}
+		operator std::string() const {
+			return value.to_string();
+		}
+	};
+
+	template <bool named>
+	struct is_source_view<basic_nbt<named>> : std::true_type {};
+
+	/// NBT with named root tag, as in files and in the protocol before 1.20.2
+	typedef basic_nbt<true> nbt;
+	/// NBT with nameless root tag of the protocol since 1.20.2
+	typedef basic_nbt<false> network_nbt;
+
+} // namespace fields
+
+} // namespace pakets
+
+} // namespace handtruth
+
+#endif // _PAKET_NBT_HEAD
@@ -0,0 +1,226 @@
+#ifndef _PAKET_SINK_HEAD
+#define _PAKET_SINK_HEAD
+
+#include "paket.hpp"
+
+#include <memory>
+
+#if __has_include(<sys/uio.h>)
+#	include <sys/uio.h>
+#endif
+
+namespace handtruth {
+
+namespace pakets {
+
+/**
+ * \brief Output sink that appends data to a growable byte array.
+ * 
+ * Storage grows geometrically, so many pakets can be encoded one after
+ * another without sizing them first.
+ */
+class vector_sink {
+	std::vector<byte_t> storage;
+	std::size_t used = 0;
+public:
+	vector_sink() = default;
+	explicit vector_sink(std::size_t capacity) : storage(capacity) {}
+
+	byte_t * reserve(std::size_t size);
+	void commit(std::size_t size) noexcept {
+		used += size;
+	}
+	std::size_t position() const noexcept {
+		return used;
+	}
+	byte_t * locate(std::size_t position) noexcept {
+		return storage.data() + position;
+	}
+	/// drops data committed after the position
+	void rewind(std::size_t position) noexcept {
+		used = position;
+	}
+
+	const byte_t * data() const noexcept {
+		return storage.data();
+	}
+	std::size_t size() const noexcept {
+		return used;
+	}
+	std::size_t capacity() const noexcept {
+		return storage.size();
+	}
+	byte_span view() const noexcept {
+		return byte_span(storage.data(), used);
+	}
+	/// forgets written data but keeps the memory
+	void clear() noexcept {
+		used = 0;
+	}
+};
+
+/**
+ * \brief Output sink over a fixed caller-provided buffer.
+ * 
+ * It never allocates. Write operations return -1 when the buffer is full.
+ */
+class arena_sink {
+	byte_t * buffer;
+	std::size_t length;
+	std::size_t used = 0;
+public:
+	constexpr arena_sink(byte_t bytes[], std::size_t size) noexcept : buffer(bytes), length(size) {}
+	template <std::size_t N>
+	constexpr arena_sink(std::array<byte_t, N> & bytes) noexcept : arena_sink(bytes.data(), N) {}
+
+	byte_t * reserve(std::size_t size) noexcept {
+		return length - used < size ? nullptr : buffer + used;
+	}
+	void commit(std::size_t size) noexcept {
+		used += size;
+	}
+	std::size_t position() const noexcept {
+		return used;
+	}
+	byte_t * locate(std::size_t position) noexcept {
+		return buffer + position;
+	}
+	/// drops data committed after the position
+	void rewind(std::size_t position) noexcept {
+		used = position;
+	}
+
+	const byte_t * data() const noexcept {
+		return buffer;
+	}
+	std::size_t size() const noexcept {
+		return used;
+	}
+	std::size_t capacity() const noexcept {
+		return length;
+	}
+	byte_span view() const noexcept {
+		return byte_span(buffer, used);
+	}
+	void clear() noexcept {
+		used = 0;
+	}
+};
+
+/**
+ * \brief Output sink that stores data in a list of blocks.
+ * 
+ * Written data is never moved. A new block is allocated when the last one
+ * has not enough space for a reservation.
+ */
+class chain_sink {
+	struct block {
+		std::unique_ptr<byte_t[]> memory;
+		std::size_t capacity;
+		std::size_t used;
+	};
+	std::vector<block> chain;
+	std::size_t block_size;
+	std::size_t total = 0;
+public:
+	static constexpr std::size_t default_block_size = 16384;
+
+	explicit chain_sink(std::size_t block_size = default_block_size) : block_size(block_size) {}
+
+	byte_t * reserve(std::size_t size);
+	void commit(std::size_t size) noexcept {
+		chain.back().used += size;
+		total += size;
+	}
+	std::size_t position() const noexcept {
+		return total;
+	}
+	byte_t * locate(std::size_t position) noexcept;
+	/// drops data committed after the position
+	void rewind(std::size_t position) noexcept;
+
+	/// total count of written bytes
+	std::size_t size() const noexcept {
+		return total;
+	}
+	/// written data of each block in order
+	std::vector<byte_span> blocks() const;
+	/// copies written data to contiguous array
+	std::vector<byte_t> collect() const;
+	/// forgets written data but keeps the first block
+	void clear() noexcept;
+};
+
+#if __has_include(<sys/uio.h>)
+/// one piece of scatter-gather output, same as iovec
+typedef ::iovec io_slice;
+#else
+/// one piece of scatter-gather output with the same layout as iovec
+struct io_slice {
+	void * iov_base;
+	std::size_t iov_len;
+};
+#endif
+
+/**
+ * \brief Output sink that produces a list of slices for `writev()` or
+ * `sendmsg()`.
+ * 
+ * Heads, varints and fixed size fields are copied into the internal
+ * scratch buffer. Payloads of strings, rest fields and byte lists that are
+ * not shorter than the threshold are referenced in place, so they must
+ * outlive the produced slices.
+ */
+class gather_sink {
+	struct piece {
+		const byte_t * external;
+		std::size_t offset;
+		std::size_t size;
+	};
+	std::vector<byte_t> scratch;
+	std::vector<piece> pieces;
+	std::size_t used = 0;
+	std::size_t total = 0;
+	std::size_t min_reference;
+public:
+	static constexpr std::size_t default_threshold = 512;
+
+	/**
+	 * \param threshold payloads shorter than this are copied to the scratch buffer
+	 */
+	explicit gather_sink(std::size_t threshold = default_threshold) : min_reference(threshold) {}
+
+	byte_t * reserve(std::size_t size);
+	void commit(std::size_t size);
+	void reference(const byte_t bytes[], std::size_t size);
+	std::size_t position() const noexcept {
+		return total;
+	}
+	byte_t * locate(std::size_t position) noexcept;
+	/// drops data committed after the position
+	void rewind(std::size_t position) noexcept;
+
+	/// total count of written bytes
+	std::size_t size() const noexcept {
+		return total;
+	}
+	std::size_t threshold() const noexcept {
+		return min_reference;
+	}
+
+	/**
+	 * Builds the list of slices with all the written data in order.
+	 * Slices are valid until the next write to the sink.
+	 */
+	std::vector<io_slice> slices() const;
+	void clear() noexcept {
+		pieces.clear();
+		used = total = 0;
+	}
+};
+
+} // namespace pakets
+
+} // namespace handtruth
+
+#endif // _PAKET_SINK_HEAD
@@ -0,0 +1,111 @@
+#ifndef _PAKET_STREAM_HEAD
+#define _PAKET_STREAM_HEAD
+
+#include "paket.hpp"
+
+namespace handtruth {
+
+namespace pakets {
+
+/**
+ * \brief Complete frame found in the stream.
+ * 
+ * Frame refers to the memory of the stream buffer. It stays valid until
+ * the next call of paket_stream::prepare() or paket_stream::feed().
+ */
+struct frame {
+	/// id of the paket in the frame
+	std::int32_t id = 0;
+	/// whole frame including length prefix, suitable for paket::read()
+	byte_span data;
+	/// bytes of the frame after paket id
+	byte_span body;
+};
+
+/**
+ * \brief Incremental framer for data that comes in chunks of arbitrary size.
+ * 
+ * Received bytes are appended to a single buffer which can be filled
+ * directly by the socket through prepare() and commit(). Frame boundaries
+ * are tracked as the data arrives, so each frame header is parsed once and
+ * complete frames are returned without copying. The buffer is compacted
+ * only when there is no free space after the received data.
+ */
+class paket_stream {
+	std::vector<byte_t> buffer;
+	std::size_t first = 0;
+	std::size_t last = 0;
+	std::size_t scan = 0;
+	std::size_t scan_end = 0;
+	std::size_t frames = 0;
+	std::size_t max_frame;
+	bool scan_known = false;
+
+	void scan_frames();
+public:
+	/// greatest frame size that can be encoded in 3 bytes long varint
+	static constexpr std::size_t default_max_frame_size = 2097151;
+
+	explicit paket_stream(std::size_t max_frame_size = default_max_frame_size);
+
+	/**
+	 * Get space for incoming data.
+	 * 
+	 * \param size minimum count of bytes to be written
+	 * \return pointer to at least size writable bytes
+	 */
+	byte_t * prepare(std::size_t size);
+
+	/**
+	 * Appends bytes written to the space returned by prepare() to the stream.
+	 * 
+	 * \param size count of written bytes
+	 * \throws paket_error if frame length is malformed or too big
+	 */
+	void commit(std::size_t size);
+
+	/**
+	 * Copies bytes to the stream.
+	 * 
+	 * \throws paket_error if frame length is malformed or too big
+	 */
+	void feed(const byte_t bytes[], std::size_t length);
+
+	/**
+	 * Takes the next complete frame from the stream.
+	 * 
+	 * \param result the found frame
+	 * \return false if there is no complete frame yet
+	 * \throws paket_error if frame does not contain valid paket id
+	 */
+	bool next(frame & result);
+
+	/// count of received bytes that are not yet taken as frames
+	std::size_t buffered() const noexcept {
+		return last - first;
+	}
+
+	/// count of complete frames that are ready to be taken
+	std::size_t pending() const noexcept {
+		return frames;
+	}
+
+	/// count of bytes that are required to complete the next unfinished frame, 0 if unknown
+	std::size_t expected() const noexcept {
+		return scan_known ? scan_end - last : 0;
+	}
+
+	/// size of the stream buffer
+	std::size_t capacity() const noexcept {
+		return buffer.size();
+	}
+
+	/// drops all the received data
+	void clear() noexcept;
+};
+
+} // namespace pakets
+
+} // namespace handtruth
+
+#endif // _PAKET_STREAM_HEAD
@@ -0,0 +1,193 @@
+#ifndef _PAKET_VIEW_HEAD
+#define _PAKET_VIEW_HEAD
+
+#include "paket.hpp"
+#include "paket_stream.hpp"
+
+namespace handtruth {
+
+namespace pakets {
+
+/**
+ * \brief Read-only view of a paket frame that decodes fields on demand.
+ *
+ * View refers to the frame bytes and does not own them. Offset of a field
+ * is found the first time it is needed and remembered, so every field is
+ * skipped at most once. get() decodes only the requested field.
+ */
+template <typename paket_t>
+class paket_view {
+public:
+	template <std::size_t i>
+	using field_type = typename paket_t::template field_type<i>;
+
+	template <std::size_t i>
+	using value_type = typename paket_t::template value_type<i>;
+
+private:
+	static constexpr std::size_t count = paket_t::fields_count();
+
+	const byte_t * bytes = nullptr;
+	std::size_t length = 0;
+	// offsets[0..known] are valid
+	mutable std::array<std::size_t, count + 1> offsets {};
+	mutable std::size_t known = 0;
+
+	[[noreturn]] static void truncated(std::size_t i) {
+		detail::raise("paket body is too small for field #" + std::to_string(i));
+	}
+
+	template <std::size_t i>
+	std::size_t scan(std::size_t offset) const {
+		int s = field_type<i>::skip(bytes + offset, length - offset);
+		if (s == -1)
+			truncated(i);
+		if (s < 0)
+			detail::raise(static_cast<paket_errc>(s), offset);
+		return static_cast<std::size_t>(s);
+	}
+
+public:
+	paket_view() noexcept {}
+	/**
+	 * Constructs view of the paket body.
+	 *
+	 * \param body bytes of the frame after the paket id
+	 */
+	paket_view(const byte_t body[], std::size_t length) noexcept : bytes(body), length(length) {}
+	explicit paket_view(byte_span body) noexcept : paket_view(body.data(), body.size()) {}
+	/**
+	 * Constructs view of the frame taken from paket_stream.
+	 *
+	 * \throws paket_error if frame has other paket id
+	 */
+	explicit paket_view(const frame & source) : paket_view(source.body) {
+		if (source.id != paket_t::static_id())
+			detail::raise("wrong paket id (" + std::to_string(paket_t::static_id()) + " expected, got " + std::to_string(source.id) + ")");
+	}
+
+	/**
+	 * Points the view to the frame. Fields are not decoded.
+	 *
+	 * \return count of bytes in the frame or -1 if frame is incomplete
+	 * \throws paket_error if frame is malformed or has other paket id
+	 */
+	int read(const byte_t frame[], std::size_t size) {
+		std::int32_t frame_size;
+		std::int32_t id;
+		int k = read_varint(frame_size, frame, size);
+		if (k < 0)
+			return -1;
+		// waiting for more data would not fix the negative length
+		if (frame_size < 0)
+			detail::raise(paket_errc::wrong_frame, 0);
+		if (static_cast<std::size_t>(frame_size) + k > size)
+			return -1;
+		int s = read_varint(id, frame + k, frame_size);
+		if (s < 0)
+			detail::raise("frame is too small for paket id");
+		if (id != paket_t::static_id())
+			detail::raise("wrong paket id (" + std::to_string(paket_t::static_id()) + " expected, got " + std::to_string(id) + ")");
+		bytes = frame + k + s;
+		length = static_cast<std::size_t>(frame_size - s);
+		known = 0;
+		return k + frame_size;
+	}
+	template <std::size_t N>
+	inline int read(const std::array<byte_t, N> & frame, std::size_t size = N) {
+		return read(frame.data(), size);
+	}
+
+	byte_span body() const noexcept {
+		return byte_span(bytes, length);
+	}
+
+	/**
+	 * Finds offset of the field in the paket body. Fields before it are
+	 * skipped without decoding, once per frame.
+	 *
+	 * \throws paket_error if paket body ends before the field
+	 */
+	template <std::size_t i>
+	std::size_t offset() const {
+		static_assert(i <= count, "field index is out of range");
+		if constexpr (i > 0) {
+			if (known < i) {
+				std::size_t previous = offset<i - 1>();
+				offsets[i] = previous + scan<i - 1>(previous);
+				known = i;
+			}
+		}
+		return offsets[i];
+	}
+
+	/**
+	 * \return encoded bytes of the field
+	 * \throws paket_error if paket body ends before the end of the field
+	 */
+	template <std::size_t i>
+	byte_span data() const {
+		std::size_t begin = offset<i>();
+		return byte_span(bytes + begin, offset<i + 1>() - begin);
+	}
+
+	/**
+	 * Decodes the field into the existing field object, so its memory
+	 * may be reused.
+	 *
+	 * \throws paket_error if paket body ends before the end of the field
+	 */
+	template <std::size_t i>
+	void get(field_type<i> & field) const {
+		std::size_t begin = offset<i>();
+		int s = field.read(bytes + begin, length - begin);
+		if (s < 0)
+			truncated(i);
+		if (known == i) {
+			offsets[i + 1] = begin + static_cast<std::size_t>(s);
+			known = i + 1;
+		}
+	}
+
+	/**
+	 * Decodes the field.
+	 *
+	 * \throws paket_error if paket body ends before the end of the field
+	 */
+	template <std::size_t i>
+	value_type<i> get() const {
+		field_type<i> field;
+		get<i>(field);
+		return std::move(field.value);
+	}
+
+	/**
+	 * Checks that all fields are present in the paket body and there are
+	 * no bytes after them.
+	 *
+	 * \throws paket_error if paket body does not match paket fields
+	 */
+	void validate() const {
+		std::size_t size = offset<count>();
+		if (size != length)
+			detail::raise("wrong paket size (" + std::to_string(length) + " bytes of paket body expected, got " + std::to_string(size) + ")");
+	}
+
+	/**
+	 * Decodes all fields into the paket.
+	 *
+	 * \throws paket_error if paket body does not match paket fields
+	 */
+	void to(paket_t & result) const {
+		int s = result.read_body(bytes, length);
+		if (s < 0 || static_cast<std::size_t>(s) != length)
+			detail::raise("wrong paket size (" + std::to_string(length) + " bytes of paket body expected, got "
+				+ (s < 0 ? std::string("more") : std::to_string(s)) + ")");
+	}
+};
+
+} // namespace pakets
+
+} // namespace handtruth
+
+#endif // _PAKET_VIEW_HEAD
@@ -0,0 +1,173 @@
+#ifndef _PAKET_ZLIB_HEAD
+#define _PAKET_ZLIB_HEAD
+
+#include "paket.hpp"
+#include "paket_sink.hpp"
+#include "paket_stream.hpp"
+
+#include <memory>
+#include <memory_resource>
+
+namespace handtruth {
+
+namespace pakets {
+
+/**
+ * \brief Codec for Minecraft compressed framing.
+ * 
+ * After compression is enabled every frame looks like
+ * `[varint frame length][varint data length][id + body]`. Data length is
+ * the size of uncompressed id and body, and id with body are compressed
+ * with zlib. If data length is 0, id with body are stored as is, which is
+ * done for pakets smaller than the threshold.
+ * 
+ * Codec keeps deflate and inflate streams and its buffers between calls,
+ * so one codec object should be used per connection and per thread.
+ */
+class compression_codec {
+	struct streams;
+	std::unique_ptr<streams> zlib;
+	std::size_t limit;
+	std::size_t max_data;
+	vector_sink scratch;
+	std::vector<byte_t> inflated;
+
+	std::size_t bound(std::size_t size) const noexcept;
+	std::size_t compress(const byte_t data[], std::size_t size, byte_t out[], std::size_t length);
+	void decompress(const byte_t data[], std::size_t size, byte_t out[], std::size_t length);
+public:
+	/// greatest uncompressed size accepted by vanilla Minecraft
+	static constexpr std::size_t default_max_data_size = 8388608;
+
+	/**
+	 * \param threshold pakets with id and body smaller than this are not compressed
+	 * \param level zlib compression level from 0 to 9 or -1 for the default one
+	 * \param max_data_size greatest accepted uncompressed size of id and body
+	 */
+	explicit compression_codec(std::size_t threshold, int level = -1, std::size_t max_data_size = default_max_data_size);
+	compression_codec(compression_codec &&) noexcept;
+	compression_codec & operator=(compression_codec &&) noexcept;
+	~compression_codec();
+
+	std::size_t threshold() const noexcept {
+		return limit;
+	}
+
+	/**
+	 * Appends compressed frame with the id and body to the sink.
+	 * 
+	 * \param data paket id followed by paket body
+	 * \return count of written bytes or -1 if the sink has no space
+	 */
+	template <typename sink_t>
+	detail::enable_if_sink_t<sink_t> write_frame(const byte_t data[], std::size_t size, sink_t & sink) {
+		constexpr std::size_t max_head = max_varnum_size<std::int32_t>();
+		if (size < limit) {
+			// skip compression, data length is 0
+			byte_t * bytes = sink.reserve(max_head + 1 + size);
+			if (bytes == nullptr)
+				return -1;
+			int k = write_varint(static_cast<std::int32_t>(size + 1), bytes, max_head);
+			bytes[k] = 0;
+			std::memcpy(bytes + k + 1, data, size);
+			sink.commit(k + 1 + size);
+			return static_cast<int>(k + 1 + size);
+		}
+		std::size_t capacity = bound(size);
+		byte_t * bytes = sink.reserve(2 * max_head + capacity);
+		if (bytes == nullptr)
+			return -1;
+		std::size_t compressed = compress(data, size, bytes + 2 * max_head, capacity);
+		byte_t head[2 * max_head];
+		int d = write_varint(static_cast<std::int32_t>(size), head + max_head, max_head);
+		int k = write_varint(static_cast<std::int32_t>(d + compressed), head, max_head);
+		std::memmove(head + k, head + max_head, d);
+		std::memmove(bytes + k + d, bytes + 2 * max_head, compressed);
+		std::memcpy(bytes, head, k + d);
+		sink.commit(k + d + compressed);
+		return static_cast<int>(k + d + compressed);
+	}
+
+	/**
+	 * Encodes paket and appends it to the sink as a compressed frame.
+	 * 
+	 * \return count of written bytes or -1 if the sink has no space
+	 */
+	template <typename paket_t, typename sink_t>
+	detail::enable_if_sink_t<sink_t> write(const paket_t & paket, sink_t & sink) {
+		constexpr std::size_t max_head = max_varnum_size<std::int32_t>();
+		std::size_t size = size_varnum(paket.id()) + paket.size();
+		if (size < limit) {
+			// nothing to deflate, so fields are encoded straight into the sink
+			auto start = detail::mark(sink);
+			byte_t * bytes = sink.reserve(2 * max_head + 1);
+			if (bytes == nullptr)
+				return -1;
+			int k = write_varint(static_cast<std::int32_t>(size + 1), bytes, max_head);
+			bytes[k++] = 0;
+			k += write_varint(paket.id(), bytes + k, max_head);
+			sink.commit(static_cast<std::size_t>(k));
+			int s = paket.write_body(sink);
+			if (s < 0)
+				return detail::rewind(sink, start);
+			return k + s;
+		}
+		// scratch holds the deflate input
+		scratch.clear();
+		byte_t * id = scratch.reserve(max_head);
+		scratch.commit(static_cast<std::size_t>(write_varint(paket.id(), id, max_head)));
+		paket.write_body(scratch);
+		return write_frame(scratch.data(), scratch.size(), sink);
+	}
+
+	/**
+	 * Encodes paket to the buffer as a compressed frame.
+	 * 
+	 * \return count of written bytes or -1 if buffer is too small
+	 */
+	template <typename paket_t>
+	int write(const paket_t & paket, byte_t bytes[], std::size_t length) {
+		arena_sink out(bytes, length);
+		return write(paket, out);
+	}
+
+	/**
+	 * Decodes compressed frame.
+	 * 
+	 * Body of the result refers to the input if the frame was not compressed.
+	 * Otherwise it is inflated to the memory of the resource if it is
+	 * specified, or to the codec buffer which is reused by the next call.
+	 * Data of the result refers to the frame as it was received.
+	 * 
+	 * \param resource memory for inflated data, for example an arena for the current tick
+	 * \return count of bytes in the frame or -1 if frame is incomplete
+	 * \throws paket_error if frame is malformed
+	 */
+	int read_frame(const byte_t bytes[], std::size_t length, frame & result, std::pmr::memory_resource * resource = nullptr);
+
+	/**
+	 * Decodes compressed frame to the paket.
+	 * 
+	 * \return count of bytes in the frame or -1 if frame is incomplete
+	 * \throws paket_error if frame is malformed or contains other paket
+	 */
+	template <typename paket_t>
+	int read(paket_t & paket, const byte_t bytes[], std::size_t length) {
+		frame result;
+		int size = read_frame(bytes, length, result);
+		if (size < 0)
+			return -1;
+		if (result.id != paket.id())
+			detail::raise("wrong paket id (" + std::to_string(paket.id()) + " expected, got " + std::to_string(result.id) + ")");
+		int s = paket.read_body(result.body.data(), result.body.size());
+		if (s < 0 || static_cast<std::size_t>(s) != result.body.size())
+			detail::raise("wrong paket size (" + std::to_string(result.body.size()) + " bytes of paket body expected)");
+		return size;
+	}
+};
+
+} // namespace pakets
+
+} // namespace handtruth
+
+#endif // _PAKET_ZLIB_HEAD
@@ -2,13 +2,591 @@
 
 #include <exception>
 #include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#	define PAKET_X86_DISPATCH
+#	include <immintrin.h>
+#endif
+
+#ifdef __GNUC__
+#	define PAKET_FORCE_INLINE inline __attribute__((always_inline))
+#else
+#	define PAKET_FORCE_INLINE inline
+#endif
 
 namespace handtruth {
 
 namespace pakets {
 
+namespace {
+
+constexpr std::uint64_t varnum_stop_bits = 0x8080808080808080ull;
+constexpr std::uint64_t varnum_payload_bits = 0x7f7f7f7f7f7f7f7full;
+
+inline std::uint64_t load_le64(const byte_t bytes[]) noexcept {
+#	ifdef PAKET_BIG_ENDIAN
+		std::uint64_t word = 0;
+		for (int i = 7; i >= 0; --i)
+			word = (word << 8) | bytes[i];
+		return word;
+#	else
+		std::uint64_t word;
+		std::memcpy(&word, bytes, sizeof(word));
+		return word;
+#	endif
+}
+
+inline int count_trailing_zeros(std::uint64_t word) noexcept {
+#	ifdef __GNUC__
+		return __builtin_ctzll(word);
+#	else
+		int n = 0;
+		while ((word & 1) == 0) {
+			word >>= 1;
+			++n;
+		}
+		return n;
+#	endif
+}
+
+// Finds terminator byte of varnum in the block and masks out everything after it.
+inline int varnum_block_bytes(std::uint64_t & word) noexcept {
+	std::uint64_t stops = ~word & varnum_stop_bits;
+	if (stops == 0)
+		return 0;
+	int n = (count_trailing_zeros(stops) >> 3) + 1;
+	if (n != 8)
+		word &= (std::uint64_t(1) << (8 * n)) - 1;
+	return n;
+}
+
+inline std::uint64_t compact_varnum_generic(std::uint64_t word) noexcept {
+	word &= varnum_payload_bits;
+	word = ((word & 0x7f007f007f007f00ull) >> 1) | (word & 0x007f007f007f007full);
+	word = ((word & 0x3fff00003fff0000ull) >> 2) | (word & 0x00003fff00003fffull);
+	word = ((word & 0x0fffffff00000000ull) >> 4) | (word & 0x000000000fffffffull);
+	return word;
+}
+
+int read_varnum_block_generic(std::uint64_t & value, const byte_t bytes[]) noexcept {
+	std::uint64_t word = load_le64(bytes);
+	int n = varnum_block_bytes(word);
+	if (n == 0)
+		return 0;
+	value = compact_varnum_generic(word);
+	return n;
+}
+
+template <std::uint64_t (*compact)(std::uint64_t) noexcept>
+PAKET_FORCE_INLINE std::size_t read_varnum_window_with(std::uint64_t values[], std::size_t max_count, std::size_t limit,
+											const byte_t bytes[], std::size_t & count) noexcept {
+	std::uint64_t word = load_le64(bytes);
+	std::uint64_t stops = ~word & varnum_stop_bits;
+	if (stops == varnum_stop_bits && max_count >= 8) {
+		// the most common case: eight single byte varnums
+		for (std::size_t i = 0; i < 8; ++i)
+			values[i] = bytes[i];
+		count = 8;
+		return 8;
+	}
+	std::size_t start = 0;
+	std::size_t n = 0;
+	while (stops != 0 && n < max_count) {
+		std::size_t end = (count_trailing_zeros(stops) >> 3) + 1;
+		std::size_t size = end - start;
+		if (size > limit)
+			break;
+		std::uint64_t segment = word >> (8 * start);
+		if (size != 8)
+			segment &= (std::uint64_t(1) << (8 * size)) - 1;
+		values[n++] = compact(segment);
+		start = end;
+		stops &= stops - 1;
+	}
+	count = n;
+	return start;
+}
+
+std::size_t read_varnum_window_generic(std::uint64_t values[], std::size_t max_count, std::size_t limit,
+										const byte_t bytes[], std::size_t & count) noexcept {
+	return read_varnum_window_with<compact_varnum_generic>(values, max_count, limit, bytes, count);
+}
+
+#ifdef PAKET_X86_DISPATCH
+
+__attribute__((target("bmi2")))
+int read_varnum_block_bmi2(std::uint64_t & value, const byte_t bytes[]) noexcept {
+	std::uint64_t word = load_le64(bytes);
+	int n = varnum_block_bytes(word);
+	if (n == 0)
+		return 0;
+	value = _pext_u64(word, varnum_payload_bits);
+	return n;
+}
+
+__attribute__((target("bmi2")))
+inline std::uint64_t compact_varnum_bmi2(std::uint64_t word) noexcept {
+	return _pext_u64(word, varnum_payload_bits);
+}
+
+__attribute__((target("bmi2")))
+std::size_t read_varnum_window_bmi2(std::uint64_t values[], std::size_t max_count, std::size_t limit,
+									const byte_t bytes[], std::size_t & count) noexcept {
+	return read_varnum_window_with<compact_varnum_bmi2>(values, max_count, limit, bytes, count);
+}
+
+#endif // PAKET_X86_DISPATCH
+
+bool cpu_has_bmi2() noexcept {
+#	ifdef PAKET_X86_DISPATCH
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("bmi2");
+#	else
+		return false;
+#	endif
+}
+
+// Kernels start with resolvers, so they are usable even during static initialization.
+
+typedef int (*varnum_block_reader)(std::uint64_t &, const byte_t[]) noexcept;
+
+int resolve_varnum_block_reader(std::uint64_t & value, const byte_t bytes[]) noexcept;
+
+std::atomic<varnum_block_reader> varnum_block_reader_impl { resolve_varnum_block_reader };
+
+int resolve_varnum_block_reader(std::uint64_t & value, const byte_t bytes[]) noexcept {
+	varnum_block_reader reader = read_varnum_block_generic;
+#	ifdef PAKET_X86_DISPATCH
+		if (cpu_has_bmi2())
+			reader = read_varnum_block_bmi2;
+#	endif
+	varnum_block_reader_impl.store(reader, std::memory_order_relaxed);
+	return reader(value, bytes);
+}
+
+typedef std::size_t (*varnum_window_reader)(std::uint64_t [], std::size_t, std::size_t, const byte_t[], std::size_t &) noexcept;
+
+std::size_t resolve_varnum_window_reader(std::uint64_t values[], std::size_t max_count, std::size_t limit,
+										const byte_t bytes[], std::size_t & count) noexcept;
+
+std::atomic<varnum_window_reader> varnum_window_reader_impl { resolve_varnum_window_reader };
+
+std::size_t resolve_varnum_window_reader(std::uint64_t values[], std::size_t max_count, std::size_t limit,
+										const byte_t bytes[], std::size_t & count) noexcept {
+	varnum_window_reader reader = read_varnum_window_generic;
+#	ifdef PAKET_X86_DISPATCH
+		if (cpu_has_bmi2())
+			reader = read_varnum_window_bmi2;
+#	endif
+	varnum_window_reader_impl.store(reader, std::memory_order_relaxed);
+	return reader(values, max_count, limit, bytes, count);
+}
+
+template <typename raw_t>
+void swap_bytes_scalar(byte_t destination[], const byte_t source[], std::size_t count) noexcept {
+	for (std::size_t i = 0; i < count; ++i) {
+		raw_t raw;
+		std::memcpy(&raw, source + i * sizeof(raw_t), sizeof(raw_t));
+		raw = detail::byte_swap(raw);
+		std::memcpy(destination + i * sizeof(raw_t), &raw, sizeof(raw_t));
+	}
+}
+
+void swap_bytes_generic(byte_t destination[], const byte_t source[], std::size_t count, std::size_t width) noexcept {
+	switch (width) {
+		case 2:
+			swap_bytes_scalar<std::uint16_t>(destination, source, count);
+			break;
+		case 4:
+			swap_bytes_scalar<std::uint32_t>(destination, source, count);
+			break;
+		case 8:
+			swap_bytes_scalar<std::uint64_t>(destination, source, count);
+			break;
+		default:
+			std::memcpy(destination, source, count * width);
+	}
+}
+
+#ifdef PAKET_X86_DISPATCH
+
+// shuffle that reverses bytes of each value inside 16 byte lane
+alignas(16) const byte_t swap_masks[3][16] = {
+	{ 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 },
+	{ 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 },
+	{ 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8 }
+};
+
+inline int swap_mask_index(std::size_t width) noexcept {
+	return width == 2 ? 0 : width == 4 ? 1 : 2;
+}
+
+__attribute__((target("ssse3")))
+void swap_bytes_ssse3(byte_t destination[], const byte_t source[], std::size_t count, std::size_t width) noexcept {
+	if (width != 2 && width != 4 && width != 8)
+		return swap_bytes_generic(destination, source, count, width);
+	const __m128i mask = _mm_load_si128(reinterpret_cast<const __m128i *>(swap_masks[swap_mask_index(width)]));
+	std::size_t size = count * width, i = 0;
+	for (; i + 16 <= size; i += 16) {
+		__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i), _mm_shuffle_epi8(block, mask));
+	}
+	swap_bytes_generic(destination + i, source + i, (size - i) / width, width);
+}
+
+__attribute__((target("avx2")))
+void swap_bytes_avx2(byte_t destination[], const byte_t source[], std::size_t count, std::size_t width) noexcept {
+	if (width != 2 && width != 4 && width != 8)
+		return swap_bytes_generic(destination, source, count, width);
+	// vpshufb shuffles each 128 bit lane separately, so the same mask is used twice
+	const __m256i mask = _mm256_broadcastsi128_si256(
+		_mm_load_si128(reinterpret_cast<const __m128i *>(swap_masks[swap_mask_index(width)])));
+	std::size_t size = count * width, i = 0;
+	for (; i + 64 <= size; i += 64) {
+		__m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + i));
+		__m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + i + 32));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(destination + i), _mm256_shuffle_epi8(first, mask));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(destination + i + 32), _mm256_shuffle_epi8(second, mask));
+	}
+	for (; i + 32 <= size; i += 32) {
+		__m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + i));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(destination + i), _mm256_shuffle_epi8(block, mask));
+	}
+	swap_bytes_generic(destination + i, source + i, (size - i) / width, width);
+}
+
+#endif // PAKET_X86_DISPATCH
+
+typedef void (*bytes_swapper)(byte_t[], const byte_t[], std::size_t, std::size_t) noexcept;
+
+void resolve_bytes_swapper(byte_t destination[], const byte_t source[], std::size_t count, std::size_t width) noexcept;
+
+std::atomic<bytes_swapper> bytes_swapper_impl { resolve_bytes_swapper };
+
+void resolve_bytes_swapper(byte_t destination[], const byte_t source[], std::size_t count, std::size_t width) noexcept {
+	bytes_swapper swapper = swap_bytes_generic;
+#	ifdef PAKET_X86_DISPATCH
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+			swapper = swap_bytes_avx2;
+		else if (__builtin_cpu_supports("ssse3"))
+			swapper = swap_bytes_ssse3;
+#	endif
+	bytes_swapper_impl.store(swapper, std::memory_order_relaxed);
+	swapper(destination, source, count, width);
+}
+
+// position of the lowest bit of the entry in the little endian bit stream of longs
+inline std::size_t entry_bit(std::size_t index, unsigned bits, bit_packing packing) noexcept {
+	if (packing == bit_packing::padded) {
+		std::size_t per_word = 64 / bits;
+		return index / per_word * 64 + index % per_word * bits;
+	}
+	return index * bits;
+}
+
+template <typename index_t>
+void unpack_bits_generic(index_t destination[], std::size_t begin, std::size_t count,
+						const byte_t source[], unsigned bits, bit_packing packing) noexcept {
+	const std::uint64_t mask = (std::uint64_t(1) << bits) - 1;
+	std::size_t position = entry_bit(begin, bits, packing);
+	std::size_t word = position / 64;
+	unsigned offset = position % 64;
+	for (std::size_t i = begin; i < count; ++i) {
+		std::uint64_t entry = detail::load_big_endian<std::uint64_t>(source + word * 8) >> offset;
+		if (offset + bits > 64)
+			entry |= detail::load_big_endian<std::uint64_t>(source + word * 8 + 8) << (64 - offset);
+		destination[i] = static_cast<index_t>(entry & mask);
+		offset += bits;
+		if (packing == bit_packing::padded ? offset + bits > 64 : offset >= 64) {
+			++word;
+			offset = packing == bit_packing::padded ? 0 : offset - 64;
+		}
+	}
+}
+
+template <typename index_t>
+void unpack_bits_generic(index_t destination[], std::size_t count, const byte_t source[], unsigned bits, bit_packing packing) noexcept {
+	unpack_bits_generic(destination, 0, count, source, bits, packing);
+}
+
+template <typename index_t>
+void pack_bits_generic(byte_t destination[], std::size_t first_word, const index_t source[], std::size_t count,
+						unsigned bits, bit_packing packing) noexcept {
+	const std::uint64_t mask = (std::uint64_t(1) << bits) - 1;
+	const std::size_t words = detail::packed_words(count, bits, packing);
+	for (std::size_t w = first_word; w < words; ++w) {
+		std::uint64_t word = 0;
+		if (packing == bit_packing::padded) {
+			std::size_t per_word = 64 / bits;
+			for (std::size_t j = 0, i = w * per_word; j < per_word && i < count; ++j, ++i)
+				word |= (source[i] & mask) << (j * bits);
+		} else {
+			// the first entry may start in the previous word
+			for (std::size_t i = w * 64 / bits; i < count && i * bits < (w + 1) * 64; ++i) {
+				std::uint64_t entry = source[i] & mask;
+				if (i * bits >= w * 64)
+					word |= entry << (i * bits - w * 64);
+				else
+					word |= entry >> (w * 64 - i * bits);
+			}
+		}
+		detail::store_big_endian(destination + w * 8, word);
+	}
+}
+
+template <typename index_t>
+void pack_bits_generic(byte_t destination[], const index_t source[], std::size_t count, unsigned bits, bit_packing packing) noexcept {
+	pack_bits_generic(destination, 0, source, count, bits, packing);
+}
+
+#ifdef PAKET_X86_DISPATCH
+
+// entries of up to 16 bits always fit 3 bytes of a 32 bit lane after the shift
+constexpr unsigned max_simd_bits = 16;
+
+/*
+ * Layout repeats every period of entries. Each group of the period
+ * decodes 8 entries: two 128 bit lanes are loaded from the longs that hold
+ * them, vpshufb gathers 4 bytes of every entry in little endian order
+ * (reversing the big endian longs on the way), then vpsrlvd and vpand cut
+ * the entry out of them.
+ */
+struct unpack_plan {
+	std::size_t period_entries;
+	std::size_t period_words;
+	std::size_t groups;
+	std::size_t lane_words[24][2];
+	alignas(32) byte_t shuffles[24][32];
+	alignas(32) std::uint32_t shifts[24][8];
+
+	unpack_plan(unsigned bits, bit_packing packing) noexcept {
+		if (packing == bit_packing::padded) {
+			std::size_t per_word = 64 / bits;
+			period_entries = per_word;
+			while (period_entries % 8 != 0)
+				period_entries += per_word;
+			period_words = period_entries / per_word;
+		} else {
+			period_entries = 64;
+			period_words = bits;
+		}
+		groups = period_entries / 8;
+		for (std::size_t g = 0; g < groups; ++g) {
+			for (std::size_t lane = 0; lane < 2; ++lane) {
+				std::size_t first = g * 8 + lane * 4;
+				std::size_t base = entry_bit(first, bits, packing) / 64;
+				lane_words[g][lane] = base;
+				for (std::size_t k = 0; k < 4; ++k) {
+					std::size_t position = entry_bit(first + k, bits, packing) - base * 64;
+					unsigned shift = position % 8;
+					shifts[g][lane * 4 + k] = shift;
+					for (unsigned t = 0; t < 4; ++t) {
+						std::size_t le = position / 8 + t;
+						bool needed = t <= (shift + bits - 1) / 8;
+						shuffles[g][lane * 16 + k * 4 + t] = needed ? static_cast<byte_t>(le / 8 * 8 + 7 - le % 8) : 0x80;
+					}
+				}
+			}
+		}
+	}
+};
+
+template <typename index_t>
+__attribute__((target("avx2")))
+void unpack_bits_avx2(index_t destination[], std::size_t count, const byte_t source[], unsigned bits, bit_packing packing) noexcept {
+	std::size_t words = detail::packed_words(count, bits, packing);
+	if (bits > max_simd_bits || count < 256)
+		return unpack_bits_generic(destination, count, source, bits, packing);
+	const unpack_plan plan(bits, packing);
+	const __m256i mask = _mm256_set1_epi32((1 << bits) - 1);
+	std::size_t period = 0;
+	// lanes read 16 bytes, so there should be one more long after the period
+	for (; (period + 1) * plan.period_entries <= count && (period + 1) * plan.period_words < words; ++period) {
+		const byte_t * words_begin = source + period * plan.period_words * 8;
+		index_t * entries = destination + period * plan.period_entries;
+		for (std::size_t g = 0; g < plan.groups; ++g) {
+			__m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(words_begin + plan.lane_words[g][0] * 8));
+			__m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(words_begin + plan.lane_words[g][1] * 8));
+			__m256i block = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+			block = _mm256_shuffle_epi8(block, _mm256_load_si256(reinterpret_cast<const __m256i *>(plan.shuffles[g])));
+			block = _mm256_srlv_epi32(block, _mm256_load_si256(reinterpret_cast<const __m256i *>(plan.shifts[g])));
+			block = _mm256_and_si256(block, mask);
+			if constexpr (sizeof(index_t) == 4) {
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(entries + g * 8), block);
+			} else {
+				// entries are below 2^16, so saturation never happens
+				block = _mm256_permute4x64_epi64(_mm256_packus_epi32(block, block), 0xd8);
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(entries + g * 8), _mm256_castsi256_si128(block));
+			}
+		}
+	}
+	unpack_bits_generic(destination, period * plan.period_entries, count, source, bits, packing);
+}
+
+/*
+ * Every long of the period is combined from groups of 4 entries widened
+ * to 64 bits and shifted to their places with vpsllvq. The entry that
+ * starts in the previous long is shifted right with vpsrlvq instead,
+ * shift by 64 clears the lane.
+ */
+struct pack_plan {
+	std::size_t period_entries;
+	std::size_t period_words;
+	std::size_t word_first[16];
+	std::size_t word_groups[16];
+	alignas(32) std::uint64_t left[64][4];
+	alignas(32) std::uint64_t right[64][4];
+
+	pack_plan(unsigned bits, bit_packing packing) noexcept {
+		if (packing == bit_packing::padded) {
+			period_entries = 64 / bits;
+			period_words = 1;
+		} else {
+			period_entries = 64;
+			period_words = bits;
+		}
+		std::size_t group = 0;
+		for (std::size_t w = 0; w < period_words; ++w) {
+			std::size_t first = packing == bit_packing::padded ? 0 : w * 64 / bits;
+			std::size_t last = first;
+			while (last < period_entries && entry_bit(last, bits, packing) < (w + 1) * 64)
+				++last;
+			word_first[w] = first;
+			word_groups[w] = (last - first + 3) / 4;
+			for (std::size_t e = first; e < first + word_groups[w] * 4; e += 4, ++group) {
+				for (std::size_t k = 0; k < 4; ++k) {
+					std::ptrdiff_t shift = static_cast<std::ptrdiff_t>(entry_bit(e + k, bits, packing)) - static_cast<std::ptrdiff_t>(w * 64);
+					bool inside = e + k < last;
+					left[group][k] = inside && shift >= 0 ? static_cast<std::uint64_t>(shift) : 64;
+					right[group][k] = inside && shift < 0 ? static_cast<std::uint64_t>(-shift) : 64;
+				}
+			}
+		}
+	}
+};
+
+template <typename index_t>
+__attribute__((target("avx2")))
+inline __m256i load_entries(const index_t source[]) noexcept {
+	if constexpr (sizeof(index_t) == 4)
+		return _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i *>(source)));
+	else
+		return _mm256_cvtepu16_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(source)));
+}
+
+template <typename index_t>
+__attribute__((target("avx2")))
+void pack_bits_avx2(byte_t destination[], const index_t source[], std::size_t count, unsigned bits, bit_packing packing) noexcept {
+	if (bits > max_simd_bits || count < 256)
+		return pack_bits_generic(destination, source, count, bits, packing);
+	const pack_plan plan(bits, packing);
+	const __m256i mask = _mm256_set1_epi64x((std::int64_t(1) << bits) - 1);
+	std::size_t period = 0;
+	// groups load up to 3 entries after the period
+	for (; (period + 1) * plan.period_entries + 4 <= count; ++period) {
+		const index_t * entries = source + period * plan.period_entries;
+		byte_t * words_begin = destination + period * plan.period_words * 8;
+		std::size_t group = 0;
+		for (std::size_t w = 0; w < plan.period_words; ++w) {
+			__m256i word = _mm256_setzero_si256();
+			for (std::size_t g = 0; g < plan.word_groups[w]; ++g, ++group) {
+				__m256i block = _mm256_and_si256(load_entries(entries + plan.word_first[w] + g * 4), mask);
+				__m256i left = _mm256_sllv_epi64(block, _mm256_load_si256(reinterpret_cast<const __m256i *>(plan.left[group])));
+				__m256i right = _mm256_srlv_epi64(block, _mm256_load_si256(reinterpret_cast<const __m256i *>(plan.right[group])));
+				word = _mm256_or_si256(word, _mm256_or_si256(left, right));
+			}
+			__m128i half = _mm_or_si128(_mm256_castsi256_si128(word), _mm256_extracti128_si256(word, 1));
+			half = _mm_or_si128(half, _mm_unpackhi_epi64(half, half));
+			detail::store_big_endian(words_begin + w * 8, static_cast<std::uint64_t>(_mm_cvtsi128_si64(half)));
+		}
+	}
+	pack_bits_generic(destination, period * plan.period_words, source, count, bits, packing);
+}
+
+#endif // PAKET_X86_DISPATCH
+
+template <typename index_t>
+using bits_unpacker = void (*)(index_t[], std::size_t, const byte_t[], unsigned, bit_packing) noexcept;
+
+template <typename index_t>
+void resolve_bits_unpacker(index_t destination[], std::size_t count, const byte_t source[], unsigned bits, bit_packing packing) noexcept;
+
+template <typename index_t>
+std::atomic<bits_unpacker<index_t>> bits_unpacker_impl { resolve_bits_unpacker<index_t> };
+
+template <typename index_t>
+void resolve_bits_unpacker(index_t destination[], std::size_t count, const byte_t source[], unsigned bits, bit_packing packing) noexcept {
+	bits_unpacker<index_t> unpacker = unpack_bits_generic<index_t>;
+#	ifdef PAKET_X86_DISPATCH
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+			unpacker = unpack_bits_avx2<index_t>;
+#	endif
+	bits_unpacker_impl<index_t>.store(unpacker, std::memory_order_relaxed);
+	unpacker(destination, count, source, bits, packing);
+}
+
+template <typename index_t>
+using bits_packer = void (*)(byte_t[], const index_t[], std::size_t, unsigned, bit_packing) noexcept;
+
+template <typename index_t>
+void resolve_bits_packer(byte_t destination[], const index_t source[], std::size_t count, unsigned bits, bit_packing packing) noexcept;
+
+template <typename index_t>
+std::atomic<bits_packer<index_t>> bits_packer_impl { resolve_bits_packer<index_t> };
+
+template <typename index_t>
+void resolve_bits_packer(byte_t destination[], const index_t source[], std::size_t count, unsigned bits, bit_packing packing) noexcept {
+	bits_packer<index_t> packer = pack_bits_generic<index_t>;
+#	ifdef PAKET_X86_DISPATCH
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+			packer = pack_bits_avx2<index_t>;
+#	endif
+	bits_packer_impl<index_t>.store(packer, std::memory_order_relaxed);
+	packer(destination, source, count, bits, packing);
+}
+
+} // namespace
+
+int detail::read_varnum_block(std::uint64_t & value, const byte_t bytes[]) noexcept {
+	return varnum_block_reader_impl.load(std::memory_order_relaxed)(value, bytes);
+}
+
+std::size_t detail::read_varnum_window(std::uint64_t values[], std::size_t max_count, std::size_t limit,
+										const byte_t bytes[], std::size_t & count) noexcept {
+	return varnum_window_reader_impl.load(std::memory_order_relaxed)(values, max_count, limit, bytes, count);
+}
+
+void detail::swap_bytes(byte_t destination[], const byte_t source[], std::size_t count, std::size_t width) noexcept {
+	// small arrays are not worth the indirect call
+	if (count * width < 32)
+		return swap_bytes_generic(destination, source, count, width);
+	bytes_swapper_impl.load(std::memory_order_relaxed)(destination, source, count, width);
+}
+
+void detail::unpack_bits(std::uint16_t destination[], std::size_t count, const byte_t source[], unsigned bits, bit_packing packing) noexcept {
+	bits_unpacker_impl<std::uint16_t>.load(std::memory_order_relaxed)(destination, count, source, bits, packing);
+}
+
+void detail::unpack_bits(std::uint32_t destination[], std::size_t count, const byte_t source[], unsigned bits, bit_packing packing) noexcept {
+	bits_unpacker_impl<std::uint32_t>.load(std::memory_order_relaxed)(destination, count, source, bits, packing);
+}
+
+void detail::pack_bits(byte_t destination[], const std::uint16_t source[], std::size_t count, unsigned bits, bit_packing packing) noexcept {
+	bits_packer_impl<std::uint16_t>.load(std::memory_order_relaxed)(destination, source, count, bits, packing);
+}
+
+void detail::pack_bits(byte_t destination[], const std::uint32_t source[], std::size_t count, unsigned bits, bit_packing packing) noexcept {
+	bits_packer_impl<std::uint32_t>.load(std::memory_order_relaxed)(destination, source, count, bits, packing);
+}
+
 std::size_t size_varint(std::int32_t value) {
-	return static_cast<std::size_t>(write_varint(value, nullptr, std::numeric_limits<std::size_t>::max()));
+	return size_varnum(value);
 }
 
 int read_varint(std::int32_t & value, const byte_t bytes[], std::size_t length) {
@@ -20,7 +598,7 @@ int write_varint(std::int32_t value, byte_t bytes[], std::size_t length) {
 }
 
 std::size_t size_varlong(std::int64_t value) {
-	return static_cast<std::size_t>(write_varlong(nullptr, std::numeric_limits<std::size_t>::max(), value));
+	return size_varnum(value);
 }
 
 int read_varlong(const byte_t bytes[], std::size_t length, std::int64_t & value) {
@@ -31,12 +609,28 @@ int write_varlong(byte_t bytes[], std::size_t length, std::int64_t value) {
 	return write_varnum(value, bytes, length);
 }
 
+int read_varint_bulk(std::int32_t values[], std::size_t count, const byte_t bytes[], std::size_t length) {
+	return read_varnum_bulk(values, count, bytes, length);
+}
+
+int read_varlong_bulk(std::int64_t values[], std::size_t count, const byte_t bytes[], std::size_t length) {
+	return read_varnum_bulk(values, count, bytes, length);
+}
+
+int write_varint_bulk(const std::int32_t values[], std::size_t count, byte_t bytes[], std::size_t length) {
+	return write_varnum_bulk(values, count, bytes, length);
+}
+
+int write_varlong_bulk(const std::int64_t values[], std::size_t count, byte_t bytes[], std::size_t length) {
+	return write_varnum_bulk(values, count, bytes, length);
+}
+
 std::size_t fields::varint::size() const noexcept {
 	return size_varint(value);
 }
 
-int fields::varint::read(const byte_t bytes[], std::size_t length) {
-	return read_varint(value, bytes, length);
+int fields::varint::try_read(const byte_t bytes[], std::size_t length) noexcept {
+	return try_read_varnum(value, bytes, length);
 }
 
 int fields::varint::write(byte_t bytes[], std::size_t length) const {
@@ -46,12 +640,25 @@ int fields::varint::write(byte_t bytes[], std::size_t length) const {
 fields::varint::operator std::string() const {
 	return std::to_string(value);
 }
+
+int fields::varint::read_bulk(varint fields[], std::size_t count, const byte_t bytes[], std::size_t length) noexcept {
+	return try_read_varnum_bulk(fields, count, bytes, length);
+}
+
+std::size_t fields::varint::size_bulk(const varint fields[], std::size_t count) noexcept {
+	return size_varnum_bulk(fields, count);
+}
+
+int fields::varint::write_bulk(const varint fields[], std::size_t count, byte_t bytes[], std::size_t length) {
+	return write_varnum_bulk(fields, count, bytes, length);
+}
+
 std::size_t fields::varlong::size() const noexcept {
 	return size_varlong(value);
 }
 
-int fields::varlong::read(const byte_t bytes[], std::size_t length) {
-	return read_varlong(bytes, length, value);
+int fields::varlong::try_read(const byte_t bytes[], std::size_t length) noexcept {
+	return try_read_varnum(value, bytes, length);
 }
 
 int fields::varlong::write(byte_t bytes[], std::size_t length) const {
@@ -62,27 +669,43 @@ fields::varlong::operator std::string() const {
 	return std::to_string(value);
 }
 
-std::size_t fields::string::size() const noexcept {
+int fields::varlong::read_bulk(varlong fields[], std::size_t count, const byte_t bytes[], std::size_t length) noexcept {
+	return try_read_varnum_bulk(fields, count, bytes, length);
+}
+
+std::size_t fields::varlong::size_bulk(const varlong fields[], std::size_t count) noexcept {
+	return size_varnum_bulk(fields, count);
+}
+
+int fields::varlong::write_bulk(const varlong fields[], std::size_t count, byte_t bytes[], std::size_t length) {
+	return write_varnum_bulk(fields, count, bytes, length);
+}
+
+namespace {
+
+template <typename string_t>
+std::size_t size_string(const string_t & value) noexcept {
 	std::size_t length = static_cast<std::size_t>(value.size());
 	return size_varint(length) + length;
 }
 
-int fields::string::read(const byte_t bytes[], std::size_t length) {
-	std::int32_t str_len;
-	int s = read_varint(str_len, bytes, length);
+// Reads length of string and checks that the whole string is available.
+int read_string_head(std::size_t & str_len, const byte_t bytes[], std::size_t length) noexcept {
+	std::int32_t len;
+	int s = try_read_varnum(len, bytes, length);
 	if (s < 0)
-		return -1;
-	if (str_len < 0)
-		throw paket_error("string field is lower than 0");
+		return s;
+	if (len < 0)
+		return static_cast<int>(paket_errc::negative_length);
 	std::size_t reminder = length - s;
-	std::size_t ustr_len = static_cast<std::size_t>(str_len);
-	if (reminder < ustr_len)
+	str_len = static_cast<std::size_t>(len);
+	if (reminder < str_len)
 		return -1;
-	value.assign(reinterpret_cast<const char *>(bytes + s), ustr_len);
-	return s + str_len;
+	return s;
 }
 
-int fields::string::write(byte_t bytes[], std::size_t length) const {
+template <typename string_t>
+int write_string(const string_t & value, byte_t bytes[], std::size_t length) {
 	std::int32_t str_len = static_cast<std::int32_t>(value.size());
 	int s = write_varint(str_len, bytes, length);
 	if (s < 0)
@@ -91,41 +714,211 @@ int fields::string::write(byte_t bytes[], std::size_t length) const {
 	std::size_t ustr_len = static_cast<std::size_t>(str_len);
 	if (reminder < ustr_len)
 		return -1;
-	std::memcpy(bytes + s, value.c_str(), ustr_len);
+	std::memcpy(bytes + s, value.data(), ustr_len);
 	return s + str_len;
 }
 
-fields::string::operator std::string() const {
-	return '"' + value + '"';
-}
-
-int fields::rest::read(const byte_t bytes[], std::size_t length) {
+template <typename vector_t>
+int read_bytes(vector_t & value, const byte_t bytes[], std::size_t length) {
+	if (!memory_budget::charge(length))
+		return static_cast<int>(paket_errc::budget_exceeded);
 	value.resize(length);
-	std::memcpy(value.data(), bytes, length);
+	// empty vector may have no storage at all
+	if (length != 0)
+		std::memcpy(value.data(), bytes, length);
 	return static_cast<int>(length);
 }
 
-int fields::rest::write(byte_t bytes[], std::size_t length) const {
-	auto size = value.size();
+int write_bytes(const byte_t data[], std::size_t size, byte_t bytes[], std::size_t length) {
 	if (size > length)
 		return -1;
-	std::memcpy(bytes, value.data(), size);
+	if (size != 0)
+		std::memcpy(bytes, data, size);
 	return static_cast<int>(size);
 }
 
+} // namespace
+
+std::size_t fields::string::size() const noexcept {
+	return size_string(value);
+}
+
+int fields::string::try_read(const byte_t bytes[], std::size_t length) {
+	std::size_t str_len;
+	int s = read_string_head(str_len, bytes, length);
+	if (s < 0)
+		return s;
+	if (!memory_budget::charge(str_len))
+		return static_cast<int>(paket_errc::budget_exceeded);
+	value.assign(reinterpret_cast<const char *>(bytes + s), str_len);
+	return s + static_cast<int>(str_len);
+}
+
+int fields::string::write(byte_t bytes[], std::size_t length) const {
+	return write_string(value, bytes, length);
+}
+
+int fields::string::skip(const byte_t bytes[], std::size_t length) noexcept {
+	std::size_t str_len;
+	int s = read_string_head(str_len, bytes, length);
+	if (s < 0)
+		return s;
+	return s + static_cast<int>(str_len);
+}
+
+fields::string::operator std::string() const {
+	return '"' + value + '"';
+}
+
+std::size_t fields::string_view::size() const noexcept {
+	return size_string(value);
+}
+
+int fields::string_view::try_read(const byte_t bytes[], std::size_t length) {
+	std::size_t str_len;
+	int s = read_string_head(str_len, bytes, length);
+	if (s < 0)
+		return s;
+	value = value_type(reinterpret_cast<const char *>(bytes + s), str_len);
+	return s + static_cast<int>(str_len);
+}
+
+int fields::string_view::write(byte_t bytes[], std::size_t length) const {
+	return write_string(value, bytes, length);
+}
+
+int fields::string_view::skip(const byte_t bytes[], std::size_t length) noexcept {
+	return fields::string::skip(bytes, length);
+}
+
+fields::string_view::operator std::string() const {
+	return '"' + std::string(value) + '"';
+}
+
+std::size_t fields::pmr::string::size() const noexcept {
+	return size_string(value);
+}
+
+int fields::pmr::string::try_read(const byte_t bytes[], std::size_t length) {
+	std::size_t str_len;
+	int s = read_string_head(str_len, bytes, length);
+	if (s < 0)
+		return s;
+	if (!memory_budget::charge(str_len))
+		return static_cast<int>(paket_errc::budget_exceeded);
+	value.assign(reinterpret_cast<const char *>(bytes + s), str_len);
+	return s + static_cast<int>(str_len);
+}
+
+int fields::pmr::string::write(byte_t bytes[], std::size_t length) const {
+	return write_string(value, bytes, length);
+}
+
+fields::pmr::string::operator std::string() const {
+	return '"' + std::string(value) + '"';
+}
+
+int fields::rest::try_read(const byte_t bytes[], std::size_t length) {
+	return read_bytes(value, bytes, length);
+}
+
+int fields::rest::write(byte_t bytes[], std::size_t length) const {
+	return write_bytes(value.data(), value.size(), bytes, length);
+}
+
 fields::rest::operator std::string() const {
 	return "<bytes>";
 }
 
-int head(const byte_t bytes[], std::size_t length, std::int32_t & size, std::int32_t & id) {
-	int s = read_varint(size, bytes, length);
+int fields::bytes_view::try_read(const byte_t bytes[], std::size_t length) {
+	value = value_type(bytes, length);
+	return static_cast<int>(length);
+}
+
+int fields::bytes_view::write(byte_t bytes[], std::size_t length) const {
+	return write_bytes(value.data(), value.size(), bytes, length);
+}
+
+fields::bytes_view::operator std::string() const {
+	return "<bytes>";
+}
+
+int fields::pmr::rest::try_read(const byte_t bytes[], std::size_t length) {
+	return read_bytes(value, bytes, length);
+}
+
+int fields::pmr::rest::write(byte_t bytes[], std::size_t length) const {
+	return write_bytes(value.data(), value.size(), bytes, length);
+}
+
+fields::pmr::rest::operator std::string() const {
+	return "<bytes>";
+}
+
+bool operator==(const byte_span & lhs, const byte_span & rhs) noexcept {
+	return lhs.size() == rhs.size() && (lhs.size() == 0 || std::memcmp(lhs.data(), rhs.data(), lhs.size()) == 0);
+}
+
+read_result try_head(const byte_t bytes[], std::size_t length, std::int32_t & size, std::int32_t & id) noexcept {
+	int s = try_read_varnum(size, bytes, length);
 	if (s < 0)
-		return -1;
-	int k = read_varint(id, bytes + s, length - s);
+		return { static_cast<paket_errc>(s), 0 };
+	int k = try_read_varnum(id, bytes + s, length - s);
 	if (k < 0)
+		return { static_cast<paket_errc>(k), std::size_t(s) };
+	return { paket_errc::ok, std::size_t(s) };
+}
+
+int head(const byte_t bytes[], std::size_t length, std::int32_t & size, std::int32_t & id) {
+	read_result result = try_head(bytes, length, size, id);
+	if (result)
+		return static_cast<int>(result.offset);
+	if (result.error == paket_errc::incomplete)
 		return -1;
-	else
-		return s;
+	detail::raise(result.error, result.offset);
+}
+
+thread_local memory_budget * memory_budget::current = nullptr;
+
+const char * describe(paket_errc error) noexcept {
+	switch (error) {
+		case paket_errc::ok:
+			return "success";
+		case paket_errc::incomplete:
+			return "not enough data";
+		case paket_errc::varnum_too_big:
+			return "varint is too big";
+		case paket_errc::negative_length:
+			return "length of string or list is lower than 0";
+		case paket_errc::wrong_id:
+			return "wrong paket id";
+		case paket_errc::wrong_size:
+			return "wrong paket size";
+		case paket_errc::wrong_frame:
+			return "wrong frame size";
+		case paket_errc::budget_exceeded:
+			return "memory budget exceeded";
+		case paket_errc::wrong_nbt:
+			return "malformed NBT";
+	}
+	return "unknown error";
+}
+
+void detail::raise(const std::string & message) {
+#	ifdef PAKET_NO_EXCEPTIONS
+		std::fprintf(stderr, "paket error: %s\n", message.c_str());
+		std::abort();
+#	else
+		throw paket_error(message);
+#	endif
+}
+
+void detail::raise(paket_errc error) {
+	raise(std::string(describe(error)));
+}
+
+void detail::raise(paket_errc error, std::size_t offset) {
+	raise(std::string(describe(error)) + " (at byte " + std::to_string(offset) + ")");
 }
 
 } // namespace pakets
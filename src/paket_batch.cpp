@@ -0,0 +1,240 @@
+#include "paket_batch.hpp"
+
+#include <atomic>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+namespace handtruth {
+
+namespace pakets {
+
+std::size_t scan_frames(const byte_t bytes[], std::size_t length, std::vector<frame> & frames) {
+	std::size_t offset = 0;
+	while (offset < length) {
+		std::int32_t size;
+		int k = try_read_varnum(size, bytes + offset, length - offset);
+		if (k == -1)
+			break;
+		if (k < 0)
+			detail::raise(static_cast<paket_errc>(k), offset);
+		if (size <= 0)
+			detail::raise("wrong frame size (" + std::to_string(size) + ")");
+		std::size_t frame_size = k + static_cast<std::size_t>(size);
+		if (frame_size > length - offset)
+			break;
+		frame result;
+		int s = try_read_varnum(result.id, bytes + offset + k, static_cast<std::size_t>(size));
+		if (s < 0)
+			detail::raise("frame is too small for paket id");
+		result.data = byte_span(bytes + offset, frame_size);
+		result.body = byte_span(bytes + offset + k + s, frame_size - k - s);
+		frames.push_back(result);
+		offset += frame_size;
+	}
+	return offset;
+}
+
+namespace {
+
+/// Range of chunks [next, end) packed in one word, so it can be changed with single CAS
+struct alignas(64) chunk_range {
+	std::atomic<std::uint64_t> range { 0 };
+
+	static constexpr std::uint64_t pack(std::uint32_t next, std::uint32_t end) noexcept {
+		return (static_cast<std::uint64_t>(end) << 32) | next;
+	}
+	static constexpr std::uint32_t next_of(std::uint64_t value) noexcept {
+		return static_cast<std::uint32_t>(value);
+	}
+	static constexpr std::uint32_t end_of(std::uint64_t value) noexcept {
+		return static_cast<std::uint32_t>(value >> 32);
+	}
+};
+
+} // namespace
+
+struct batch_decoder::pool {
+	struct job {
+		const std::function<void(std::size_t, std::size_t)> * task;
+		std::size_t count;
+		std::size_t chunk;
+		std::unique_ptr<chunk_range[]> ranges;
+#		ifndef PAKET_NO_EXCEPTIONS
+			std::mutex error_mutex;
+			std::exception_ptr error;
+#		endif
+		std::atomic<bool> failed { false };
+	};
+
+	std::size_t size;
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+	job * current = nullptr;
+	std::uint64_t generation = 0;
+	std::size_t running = 0;
+	bool stop = false;
+
+	explicit pool(std::size_t size) : size(size) {
+		threads.reserve(size - 1);
+		for (std::size_t i = 1; i < size; ++i)
+			threads.emplace_back([this, i]() { loop(i); });
+	}
+
+	~pool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stop = true;
+		}
+		wake.notify_all();
+		for (auto & thread : threads)
+			thread.join();
+	}
+
+	void loop(std::size_t index) {
+		std::uint64_t seen = 0;
+		for (;;) {
+			job * work;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [this, seen]() { return stop || generation != seen; });
+				if (stop)
+					return;
+				seen = generation;
+				work = current;
+			}
+			execute(*work, index);
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (--running == 0)
+					done.notify_one();
+			}
+		}
+	}
+
+	/// takes the first chunk of own range
+	static bool pop(chunk_range & own, std::uint32_t & chunk) noexcept {
+		std::uint64_t value = own.range.load(std::memory_order_relaxed);
+		for (;;) {
+			std::uint32_t next = chunk_range::next_of(value), end = chunk_range::end_of(value);
+			if (next >= end)
+				return false;
+			if (own.range.compare_exchange_weak(value, chunk_range::pack(next + 1, end), std::memory_order_acq_rel)) {
+				chunk = next;
+				return true;
+			}
+		}
+	}
+
+	/// moves the upper half of some other range to the own range
+	bool steal(job & work, std::size_t index) noexcept {
+		for (std::size_t i = 1; i < size; ++i) {
+			chunk_range & victim = work.ranges[(index + i) % size];
+			std::uint64_t value = victim.range.load(std::memory_order_relaxed);
+			for (;;) {
+				std::uint32_t next = chunk_range::next_of(value), end = chunk_range::end_of(value);
+				// the last chunk is left to the owner
+				if (next >= end || end - next < 2)
+					break;
+				std::uint32_t middle = next + (end - next) / 2;
+				if (victim.range.compare_exchange_weak(value, chunk_range::pack(next, middle), std::memory_order_acq_rel)) {
+					work.ranges[index].range.store(chunk_range::pack(middle, end), std::memory_order_release);
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	void execute(job & work, std::size_t index) {
+		chunk_range & own = work.ranges[index];
+		std::uint32_t chunk;
+		do {
+			while (pop(own, chunk)) {
+				if (work.failed.load(std::memory_order_relaxed))
+					continue;
+				std::size_t begin = chunk * work.chunk;
+				std::size_t end = std::min(begin + work.chunk, work.count);
+#				ifndef PAKET_NO_EXCEPTIONS
+					try {
+						(*work.task)(begin, end);
+					} catch (...) {
+						std::lock_guard<std::mutex> lock(work.error_mutex);
+						if (!work.error)
+							work.error = std::current_exception();
+						work.failed.store(true, std::memory_order_relaxed);
+					}
+#				else
+					(*work.task)(begin, end);
+#				endif
+			}
+		} while (steal(work, index));
+	}
+
+	void run(job & work) {
+		std::size_t chunks = (work.count + work.chunk - 1) / work.chunk;
+		work.ranges.reset(new chunk_range[size]);
+		for (std::size_t i = 0; i < size; ++i) {
+			auto begin = static_cast<std::uint32_t>(chunks * i / size);
+			auto end = static_cast<std::uint32_t>(chunks * (i + 1) / size);
+			work.ranges[i].range.store(chunk_range::pack(begin, end), std::memory_order_relaxed);
+		}
+		if (size > 1) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				current = &work;
+				running = size - 1;
+				++generation;
+			}
+			wake.notify_all();
+		}
+		execute(work, 0);
+		if (size > 1) {
+			std::unique_lock<std::mutex> lock(mutex);
+			done.wait(lock, [this]() { return running == 0; });
+			current = nullptr;
+		}
+	}
+};
+
+batch_decoder::batch_decoder(std::size_t threads, std::size_t chunk_size) : chunk(chunk_size == 0 ? 1 : chunk_size) {
+	if (threads == 0)
+		threads = std::max(std::thread::hardware_concurrency(), 1u);
+	workers.reset(new pool(threads));
+}
+
+batch_decoder::~batch_decoder() = default;
+
+std::size_t batch_decoder::threads() const noexcept {
+	return workers->size;
+}
+
+void batch_decoder::parallel_for(std::size_t count, const std::function<void(std::size_t, std::size_t)> & task) {
+	if (count == 0)
+		return;
+	std::size_t chunk_size = chunk;
+	// chunk indices must fit in 32 bits of the packed range
+	if ((count - 1) / chunk_size >= 0xFFFFFFFFu)
+		chunk_size = count / 0xFFFFFFFFu + 1;
+	if (workers->size == 1 || count <= chunk_size) {
+		task(0, count);
+		return;
+	}
+	pool::job work;
+	work.task = &task;
+	work.count = count;
+	work.chunk = chunk_size;
+	workers->run(work);
+#	ifndef PAKET_NO_EXCEPTIONS
+		if (work.error)
+			std::rethrow_exception(work.error);
+#	endif
+}
+
+} // namespace pakets
+
+} // namespace handtruth
@@ -0,0 +1,369 @@
+#include "paket_capture.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <unordered_map>
+
+#if __has_include(<sys/mman.h>)
+#	define PAKET_CAPTURE_MMAP
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
+
+namespace handtruth {
+
+namespace pakets {
+
+namespace {
+
+constexpr char capture_magic[8] = { 'P', 'A', 'K', 'E', 'T', 'C', 'A', 'P' };
+constexpr char index_magic[8] = { 'P', 'A', 'K', 'E', 'T', 'I', 'D', 'X' };
+constexpr std::uint32_t capture_version = 1;
+constexpr std::size_t file_header_size = 16;
+constexpr std::size_t record_header_size = 16;
+constexpr std::size_t entry_size = 24;
+
+void put_le(byte_t bytes[], std::uint64_t value, std::size_t size) noexcept {
+	for (std::size_t i = 0; i < size; ++i)
+		bytes[i] = static_cast<byte_t>(value >> (8 * i));
+}
+
+std::uint64_t get_le(const byte_t bytes[], std::size_t size) noexcept {
+	std::uint64_t value = 0;
+	for (std::size_t i = 0; i < size; ++i)
+		value |= static_cast<std::uint64_t>(bytes[i]) << (8 * i);
+	return value;
+}
+
+void write_file_header(byte_t bytes[], const char magic[8]) noexcept {
+	std::memcpy(bytes, magic, 8);
+	put_le(bytes + 8, capture_version, 4);
+	put_le(bytes + 12, 0, 4);
+}
+
+bool check_file_header(const byte_t bytes[], std::size_t length, const char magic[8]) noexcept {
+	return length >= file_header_size && std::memcmp(bytes, magic, 8) == 0
+		&& get_le(bytes + 8, 4) == capture_version;
+}
+
+/// Whole file mapped into memory or read into a buffer.
+class mapped_file {
+	const byte_t * bytes = nullptr;
+	std::size_t length = 0;
+#	ifdef PAKET_CAPTURE_MMAP
+		void * mapping = nullptr;
+#	endif
+	std::vector<byte_t> buffer;
+
+public:
+	mapped_file() = default;
+	mapped_file(const mapped_file &) = delete;
+	mapped_file & operator=(const mapped_file &) = delete;
+	~mapped_file() {
+#		ifdef PAKET_CAPTURE_MMAP
+			if (mapping != nullptr)
+				munmap(mapping, length);
+#		endif
+	}
+
+	/// \return false if the file does not exist
+	bool open(const std::string & path) {
+#		ifdef PAKET_CAPTURE_MMAP
+			int fd = ::open(path.c_str(), O_RDONLY);
+			if (fd < 0)
+				return false;
+			struct stat info;
+			if (fstat(fd, &info) != 0) {
+				::close(fd);
+				detail::raise("failed to stat " + path);
+			}
+			length = static_cast<std::size_t>(info.st_size);
+			if (length != 0) {
+				mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (mapping == MAP_FAILED) {
+					mapping = nullptr;
+					::close(fd);
+					detail::raise("failed to map " + path);
+				}
+				madvise(mapping, length, MADV_SEQUENTIAL);
+				bytes = static_cast<const byte_t *>(mapping);
+			}
+			::close(fd);
+#		else
+			std::ifstream in(path, std::ios::binary | std::ios::ate);
+			if (!in)
+				return false;
+			buffer.resize(static_cast<std::size_t>(in.tellg()));
+			in.seekg(0);
+			if (!in.read(reinterpret_cast<char *>(buffer.data()), buffer.size()))
+				detail::raise("failed to read " + path);
+			bytes = buffer.data();
+			length = buffer.size();
+#		endif
+		return true;
+	}
+
+	const byte_t * data() const noexcept {
+		return bytes;
+	}
+	std::size_t size() const noexcept {
+		return length;
+	}
+};
+
+/// \return size of the record at the offset or 0 if it is incomplete
+std::size_t record_size(const byte_t bytes[], std::size_t length, std::size_t offset, std::int32_t & id) {
+	if (length - offset < record_header_size)
+		return 0;
+	std::size_t frame_offset = offset + record_header_size;
+	std::int32_t size;
+	int k = try_read_varnum(size, bytes + frame_offset, length - frame_offset);
+	if (k == -1)
+		return 0;
+	if (k < 0 || size <= 0)
+		detail::raise("corrupted capture record at " + std::to_string(offset));
+	if (static_cast<std::size_t>(size) + k > length - frame_offset)
+		return 0;
+	if (try_read_varnum(id, bytes + frame_offset + k, static_cast<std::size_t>(size)) < 0)
+		detail::raise("corrupted capture record at " + std::to_string(offset));
+	return record_header_size + k + static_cast<std::size_t>(size);
+}
+
+void write_entry(byte_t entry[], std::int64_t timestamp, std::uint64_t offset, std::int32_t id, std::uint32_t connection) noexcept {
+	put_le(entry, static_cast<std::uint64_t>(timestamp), 8);
+	put_le(entry + 8, offset, 8);
+	put_le(entry + 16, static_cast<std::uint32_t>(id), 4);
+	put_le(entry + 20, connection, 4);
+}
+
+/**
+ * Builds index entries by scanning the capture.
+ *
+ * \return end of the last complete record
+ */
+std::size_t scan_records(const byte_t bytes[], std::size_t length, std::vector<byte_t> & entries) {
+	std::size_t offset = file_header_size;
+	for (;;) {
+		std::int32_t id;
+		std::size_t size = record_size(bytes, length, offset, id);
+		if (size == 0)
+			return offset;
+		byte_t entry[entry_size];
+		auto timestamp = static_cast<std::int64_t>(get_le(bytes + offset, 8));
+		auto connection = static_cast<std::uint32_t>(get_le(bytes + offset + 8, 4));
+		write_entry(entry, timestamp, offset, id, connection);
+		entries.insert(entries.end(), entry, entry + entry_size);
+		offset += size;
+	}
+}
+
+/// Checks that the last index entry describes the last record of the capture.
+bool index_matches(const mapped_file & data, const mapped_file & index) {
+	if (!check_file_header(index.data(), index.size(), index_magic) || (index.size() - file_header_size) % entry_size != 0)
+		return false;
+	std::size_t entries = (index.size() - file_header_size) / entry_size;
+	if (entries == 0)
+		return data.size() == file_header_size;
+	const byte_t * last = index.data() + index.size() - entry_size;
+	std::uint64_t offset = get_le(last + 8, 8);
+	if (offset < file_header_size || offset >= data.size())
+		return false;
+	std::int32_t id;
+	std::size_t size = record_size(data.data(), data.size(), static_cast<std::size_t>(offset), id);
+	return size != 0 && offset + size == data.size() && id == static_cast<std::int32_t>(get_le(last + 16, 4));
+}
+
+std::FILE * open_file(const std::string & path, const char * mode) {
+	std::FILE * file = std::fopen(path.c_str(), mode);
+	if (file == nullptr)
+		detail::raise("failed to open " + path);
+	return file;
+}
+
+void write_all(std::FILE * file, const void * bytes, std::size_t length) {
+	if (std::fwrite(bytes, 1, length, file) != length)
+		detail::raise("failed to write capture");
+}
+
+} // namespace
+
+capture_writer::capture_writer(const std::string & path) {
+	std::string index_path = path + ".idx";
+	mapped_file existing;
+	if (existing.open(path) && existing.size() != 0) {
+		if (!check_file_header(existing.data(), existing.size(), capture_magic))
+			detail::raise(path + " is not a capture file");
+		mapped_file existing_index;
+		existing_index.open(index_path);
+		if (index_matches(existing, existing_index)) {
+			records = (existing_index.size() - file_header_size) / entry_size;
+			offset = existing.size();
+			if (records != 0)
+				last_time = static_cast<std::int64_t>(get_le(existing_index.data() + existing_index.size() - entry_size, 8));
+		} else {
+			// writer has crashed, rebuild the index and drop the incomplete record
+			std::vector<byte_t> entries(file_header_size);
+			write_file_header(entries.data(), index_magic);
+			offset = scan_records(existing.data(), existing.size(), entries);
+			records = (entries.size() - file_header_size) / entry_size;
+			if (records != 0)
+				last_time = static_cast<std::int64_t>(get_le(entries.data() + entries.size() - entry_size, 8));
+			std::FILE * rebuilt = open_file(index_path, "wb");
+			bool ok = std::fwrite(entries.data(), 1, entries.size(), rebuilt) == entries.size();
+			ok = std::fclose(rebuilt) == 0 && ok;
+			if (!ok)
+				detail::raise("failed to write " + index_path);
+			if (offset != existing.size()) {
+				std::error_code error;
+				std::filesystem::resize_file(path, offset, error);
+				if (error)
+					detail::raise("failed to truncate " + path + ": " + error.message());
+			}
+		}
+		data = open_file(path, "ab");
+		index = std::fopen(index_path.c_str(), "ab");
+		if (index == nullptr) {
+			std::fclose(data);
+			detail::raise("failed to open " + index_path);
+		}
+	} else {
+		byte_t header[file_header_size];
+		data = open_file(path, "wb");
+		index = std::fopen(index_path.c_str(), "wb");
+		if (index == nullptr) {
+			std::fclose(data);
+			detail::raise("failed to open " + index_path);
+		}
+		write_file_header(header, capture_magic);
+		write_all(data, header, file_header_size);
+		write_file_header(header, index_magic);
+		write_all(index, header, file_header_size);
+		offset = file_header_size;
+	}
+}
+
+capture_writer::~capture_writer() {
+	std::fclose(data);
+	std::fclose(index);
+}
+
+void capture_writer::record(const byte_t bytes[], std::size_t length, pakets::direction dir, std::uint32_t connection, std::int64_t timestamp) {
+	std::int32_t size;
+	int k = try_read_varnum(size, bytes, length);
+	if (k < 0 || size <= 0 || static_cast<std::size_t>(size) + k != length)
+		detail::raise("captured bytes are not a single frame");
+	std::int32_t id;
+	if (try_read_varnum(id, bytes + k, static_cast<std::size_t>(size)) < 0)
+		detail::raise("frame is too small for paket id");
+	if (timestamp < last_time)
+		timestamp = last_time;
+	byte_t header[record_header_size] = {};
+	put_le(header, static_cast<std::uint64_t>(timestamp), 8);
+	put_le(header + 8, connection, 4);
+	header[12] = static_cast<byte_t>(dir);
+	byte_t entry[entry_size];
+	write_entry(entry, timestamp, offset, id, connection);
+	// files are buffered separately, so after a crash the index may point
+	// past the records, the reader then rebuilds it, see index_matches()
+	write_all(data, header, record_header_size);
+	write_all(data, bytes, length);
+	write_all(index, entry, entry_size);
+	offset += record_header_size + length;
+	last_time = timestamp;
+	++records;
+}
+
+void capture_writer::flush() {
+	if (std::fflush(data) != 0 || std::fflush(index) != 0)
+		detail::raise("failed to flush capture");
+}
+
+struct capture_reader::storage {
+	mapped_file data;
+	mapped_file index;
+	std::vector<byte_t> rebuilt;
+	// record indices by paket id, built once from the index entries
+	std::unordered_map<std::int32_t, std::vector<std::size_t>> by_id;
+};
+
+capture_reader::capture_reader(const std::string & path) : files(new storage()) {
+	if (!files->data.open(path))
+		detail::raise("failed to open " + path);
+	if (!check_file_header(files->data.data(), files->data.size(), capture_magic))
+		detail::raise(path + " is not a capture file");
+	files->index.open(path + ".idx");
+	if (index_matches(files->data, files->index)) {
+		index_entries = files->index.data() + file_header_size;
+		count = (files->index.size() - file_header_size) / entry_size;
+	} else {
+		scan_records(files->data.data(), files->data.size(), files->rebuilt);
+		index_entries = files->rebuilt.data();
+		count = files->rebuilt.size() / entry_size;
+	}
+	for (std::size_t i = 0; i < count; ++i)
+		files->by_id[id(i)].push_back(i);
+}
+
+capture_reader::capture_reader(capture_reader &&) noexcept = default;
+capture_reader & capture_reader::operator=(capture_reader &&) noexcept = default;
+capture_reader::~capture_reader() = default;
+
+std::int64_t capture_reader::timestamp(std::size_t i) const noexcept {
+	return static_cast<std::int64_t>(get_le(index_entries + i * entry_size, 8));
+}
+
+std::int32_t capture_reader::id(std::size_t i) const noexcept {
+	return static_cast<std::int32_t>(get_le(index_entries + i * entry_size + 16, 4));
+}
+
+std::uint32_t capture_reader::connection(std::size_t i) const noexcept {
+	return static_cast<std::uint32_t>(get_le(index_entries + i * entry_size + 20, 4));
+}
+
+capture_record capture_reader::at(std::size_t i) const {
+	const byte_t * bytes = files->data.data();
+	std::size_t length = files->data.size();
+	auto offset = static_cast<std::size_t>(get_le(index_entries + i * entry_size + 8, 8));
+	std::int32_t id;
+	std::size_t size = offset < file_header_size || offset >= length ? 0 : record_size(bytes, length, offset, id);
+	if (size == 0)
+		detail::raise("corrupted capture record at " + std::to_string(offset));
+	capture_record result;
+	result.timestamp = static_cast<std::int64_t>(get_le(bytes + offset, 8));
+	result.connection = static_cast<std::uint32_t>(get_le(bytes + offset + 8, 4));
+	result.direction = static_cast<pakets::direction>(bytes[offset + 12]);
+	const byte_t * frame_bytes = bytes + offset + record_header_size;
+	std::size_t frame_size = size - record_header_size;
+	std::int32_t body_size;
+	int k = try_read_varnum(body_size, frame_bytes, frame_size);
+	int s = try_read_varnum(result.content.id, frame_bytes + k, frame_size - k);
+	result.content.data = byte_span(frame_bytes, frame_size);
+	result.content.body = byte_span(frame_bytes + k + s, frame_size - k - s);
+	return result;
+}
+
+std::size_t capture_reader::lower_bound(std::int64_t time) const noexcept {
+	std::size_t first = 0, last = count;
+	while (first < last) {
+		std::size_t middle = first + (last - first) / 2;
+		if (timestamp(middle) < time)
+			first = middle + 1;
+		else
+			last = middle;
+	}
+	return first;
+}
+
+const std::vector<std::size_t> & capture_reader::find(std::int32_t paket_id) const {
+	static const std::vector<std::size_t> nothing;
+	auto found = files->by_id.find(paket_id);
+	return found == files->by_id.end() ? nothing : found->second;
+}
+
+} // namespace pakets
+
+} // namespace handtruth
@@ -0,0 +1,435 @@
+#include "paket_nbt.hpp"
+
+#include <cstring>
+
+namespace handtruth {
+
+namespace pakets {
+
+namespace {
+
+constexpr int tag_count = 13;
+
+// size of fixed width payload or of array element, 0 for other tags
+std::size_t fixed_width(nbt_tag type) noexcept {
+	switch (type) {
+		case nbt_tag::byte:
+		case nbt_tag::byte_array:
+			return 1;
+		case nbt_tag::int16:
+			return 2;
+		case nbt_tag::int32:
+		case nbt_tag::float32:
+		case nbt_tag::int_array:
+			return 4;
+		case nbt_tag::int64:
+		case nbt_tag::float64:
+		case nbt_tag::long_array:
+			return 8;
+		default:
+			return 0;
+	}
+}
+
+bool is_array(nbt_tag type) noexcept {
+	return type == nbt_tag::byte_array || type == nbt_tag::int_array || type == nbt_tag::long_array;
+}
+
+int skip_payload(nbt_tag type, const byte_t bytes[], std::size_t length, int depth) noexcept {
+	switch (type) {
+		case nbt_tag::byte:
+		case nbt_tag::int16:
+		case nbt_tag::int32:
+		case nbt_tag::int64:
+		case nbt_tag::float32:
+		case nbt_tag::float64: {
+			std::size_t width = fixed_width(type);
+			return length < width ? -1 : static_cast<int>(width);
+		}
+		case nbt_tag::byte_array:
+		case nbt_tag::int_array:
+		case nbt_tag::long_array: {
+			if (length < 4)
+				return -1;
+			std::int32_t count = detail::load_big_endian<std::int32_t>(bytes);
+			if (count < 0)
+				return static_cast<int>(paket_errc::negative_length);
+			std::uint64_t size = 4 + std::uint64_t(count) * fixed_width(type);
+			return size > length ? -1 : static_cast<int>(size);
+		}
+		case nbt_tag::string: {
+			if (length < 2)
+				return -1;
+			std::size_t size = 2 + std::size_t(detail::load_big_endian<std::uint16_t>(bytes));
+			return size > length ? -1 : static_cast<int>(size);
+		}
+		case nbt_tag::list: {
+			if (depth >= nbt_max_depth)
+				return static_cast<int>(paket_errc::wrong_nbt);
+			if (length < 5)
+				return -1;
+			nbt_tag element = static_cast<nbt_tag>(bytes[0]);
+			std::int32_t count = detail::load_big_endian<std::int32_t>(bytes + 1);
+			if (bytes[0] >= tag_count || (element == nbt_tag::end && count > 0))
+				return static_cast<int>(paket_errc::wrong_nbt);
+			if (count < 0)
+				return static_cast<int>(paket_errc::negative_length);
+			std::size_t width = fixed_width(element);
+			if (width != 0 && !is_array(element)) {
+				std::uint64_t size = 5 + std::uint64_t(count) * width;
+				return size > length ? -1 : static_cast<int>(size);
+			}
+			// every other element takes at least one byte, so the loop is bounded by length
+			std::size_t offset = 5;
+			for (std::int32_t i = 0; i < count; ++i) {
+				int s = skip_payload(element, bytes + offset, length - offset, depth + 1);
+				if (s < 0)
+					return s;
+				offset += s;
+			}
+			return static_cast<int>(offset);
+		}
+		case nbt_tag::compound: {
+			if (depth >= nbt_max_depth)
+				return static_cast<int>(paket_errc::wrong_nbt);
+			std::size_t offset = 0;
+			for (;;) {
+				if (offset >= length)
+					return -1;
+				byte_t entry = bytes[offset++];
+				if (entry == 0)
+					return static_cast<int>(offset);
+				if (entry >= tag_count)
+					return static_cast<int>(paket_errc::wrong_nbt);
+				if (length - offset < 2)
+					return -1;
+				std::size_t name = detail::load_big_endian<std::uint16_t>(bytes + offset);
+				offset += 2;
+				if (length - offset < name)
+					return -1;
+				offset += name;
+				int s = skip_payload(static_cast<nbt_tag>(entry), bytes + offset, length - offset, depth + 1);
+				if (s < 0)
+					return s;
+				offset += s;
+			}
+		}
+		default:
+			return static_cast<int>(paket_errc::wrong_nbt);
+	}
+}
+
+// payload of the validated tag
+std::size_t payload_size(nbt_tag type, const byte_t bytes[], const byte_t * last) noexcept {
+	std::size_t width = fixed_width(type);
+	if (width != 0 && !is_array(type))
+		return width;
+	return static_cast<std::size_t>(skip_payload(type, bytes, last - bytes, 0));
+}
+
+const char * type_name(nbt_tag type) noexcept {
+	static const char * const names[tag_count] = {
+		"TAG_End", "TAG_Byte", "TAG_Short", "TAG_Int", "TAG_Long", "TAG_Float", "TAG_Double",
+		"TAG_Byte_Array", "TAG_String", "TAG_List", "TAG_Compound", "TAG_Int_Array", "TAG_Long_Array"
+	};
+	return names[static_cast<int>(type)];
+}
+
+void append_quoted(std::string & out, std::string_view text) {
+	out += '"';
+	for (char c : text) {
+		if (c == '"' || c == '\\')
+			out += '\\';
+		out += c;
+	}
+	out += '"';
+}
+
+bool is_plain_name(std::string_view name) noexcept {
+	if (name.empty())
+		return false;
+	for (char c : name) {
+		bool plain = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+			|| c == '_' || c == '-' || c == '.' || c == '+';
+		if (!plain)
+			return false;
+	}
+	return true;
+}
+
+void append_snbt(std::string & out, const nbt_view & view) {
+	switch (view.type()) {
+		case nbt_tag::end:
+			break;
+		case nbt_tag::byte:
+			out += std::to_string(view.as_byte()) + 'b';
+			break;
+		case nbt_tag::int16:
+			out += std::to_string(view.as_int16()) + 's';
+			break;
+		case nbt_tag::int32:
+			out += std::to_string(view.as_int32());
+			break;
+		case nbt_tag::int64:
+			out += std::to_string(view.as_int64()) + 'L';
+			break;
+		case nbt_tag::float32:
+			out += std::to_string(view.as_float32()) + 'f';
+			break;
+		case nbt_tag::float64:
+			out += std::to_string(view.as_float64()) + 'd';
+			break;
+		case nbt_tag::string:
+			append_quoted(out, view.as_string());
+			break;
+		case nbt_tag::compound: {
+			out += '{';
+			bool first = true;
+			for (const nbt_view & entry : view) {
+				if (!first)
+					out += ',';
+				first = false;
+				if (is_plain_name(entry.name()))
+					out += entry.name();
+				else
+					append_quoted(out, entry.name());
+				out += ':';
+				append_snbt(out, entry);
+			}
+			out += '}';
+			break;
+		}
+		default: {
+			out += '[';
+			if (view.type() == nbt_tag::byte_array)
+				out += "B;";
+			else if (view.type() == nbt_tag::int_array)
+				out += "I;";
+			else if (view.type() == nbt_tag::long_array)
+				out += "L;";
+			bool first = true;
+			for (const nbt_view & element : view) {
+				if (!first)
+					out += ',';
+				first = false;
+				append_snbt(out, element);
+			}
+			out += ']';
+		}
+	}
+}
+
+} // namespace
+
+template <typename T>
+T nbt_view::number(nbt_tag expected) const {
+	if (tag != expected)
+		detail::raise(std::string("NBT tag is ") + type_name(tag) + ", not " + type_name(expected));
+	return detail::load_big_endian<T>(bytes);
+}
+
+std::int8_t nbt_view::as_byte() const {
+	return number<std::int8_t>(nbt_tag::byte);
+}
+
+std::int16_t nbt_view::as_int16() const {
+	return number<std::int16_t>(nbt_tag::int16);
+}
+
+std::int32_t nbt_view::as_int32() const {
+	return number<std::int32_t>(nbt_tag::int32);
+}
+
+std::int64_t nbt_view::as_int64() const {
+	return number<std::int64_t>(nbt_tag::int64);
+}
+
+float nbt_view::as_float32() const {
+	return number<float>(nbt_tag::float32);
+}
+
+double nbt_view::as_float64() const {
+	return number<double>(nbt_tag::float64);
+}
+
+std::string_view nbt_view::as_string() const {
+	if (tag != nbt_tag::string)
+		detail::raise(std::string("NBT tag is ") + type_name(tag) + ", not TAG_String");
+	return std::string_view(reinterpret_cast<const char *>(bytes + 2), length - 2);
+}
+
+byte_span nbt_view::as_bytes() const {
+	if (tag != nbt_tag::byte_array)
+		detail::raise(std::string("NBT tag is ") + type_name(tag) + ", not TAG_Byte_Array");
+	return byte_span(bytes + 4, length - 4);
+}
+
+nbt_tag nbt_view::element_type() const noexcept {
+	switch (tag) {
+		case nbt_tag::list:
+			return static_cast<nbt_tag>(bytes[0]);
+		case nbt_tag::byte_array:
+			return nbt_tag::byte;
+		case nbt_tag::int_array:
+			return nbt_tag::int32;
+		case nbt_tag::long_array:
+			return nbt_tag::int64;
+		default:
+			return nbt_tag::end;
+	}
+}
+
+std::size_t nbt_view::size() const noexcept {
+	if (tag == nbt_tag::list)
+		return static_cast<std::size_t>(detail::load_big_endian<std::int32_t>(bytes + 1));
+	if (is_array(tag))
+		return static_cast<std::size_t>(detail::load_big_endian<std::int32_t>(bytes));
+	if (tag == nbt_tag::compound)
+		return static_cast<std::size_t>(std::distance(begin(), end()));
+	return 0;
+}
+
+const byte_t * nbt_view::element(std::size_t index, nbt_tag & type, std::size_t & size) const noexcept {
+	if (index >= this->size())
+		return nullptr;
+	type = element_type();
+	const byte_t * first = bytes + (tag == nbt_tag::list ? 5 : 4);
+	std::size_t width = fixed_width(type);
+	if (width != 0 && !is_array(type)) {
+		size = width;
+		return first + index * width;
+	}
+	const byte_t * last = bytes + length;
+	for (std::size_t i = 0; i < index; ++i)
+		first += payload_size(type, first, last);
+	size = payload_size(type, first, last);
+	return first;
+}
+
+nbt_view nbt_view::operator[](std::size_t index) const noexcept {
+	nbt_tag type;
+	std::size_t size;
+	const byte_t * payload = element(index, type, size);
+	if (payload == nullptr)
+		return nbt_view();
+	return nbt_view(type, payload, size);
+}
+
+nbt_view nbt_view::operator[](std::string_view name) const noexcept {
+	if (tag != nbt_tag::compound)
+		return nbt_view();
+	for (const nbt_view & entry : *this)
+		if (entry.name() == name)
+			return entry;
+	return nbt_view();
+}
+
+nbt_view::iterator nbt_view::begin() const noexcept {
+	iterator result = end();
+	if (tag == nbt_tag::compound) {
+		result.position = bytes;
+	} else if (tag == nbt_tag::list || is_array(tag)) {
+		result.position = bytes + (tag == nbt_tag::list ? 5 : 4);
+		result.element = element_type();
+	}
+	result.load();
+	return result;
+}
+
+nbt_view::iterator nbt_view::end() const noexcept {
+	iterator result;
+	result.container = tag;
+	if (tag == nbt_tag::compound)
+		// TAG_End that closes the compound
+		result.position = result.last = bytes + length - 1;
+	else if (tag == nbt_tag::list || is_array(tag))
+		result.position = result.last = bytes + length;
+	return result;
+}
+
+void nbt_view::iterator::load() noexcept {
+	if (position == last) {
+		current = nbt_view();
+		return;
+	}
+	if (container == nbt_tag::compound) {
+		nbt_tag type = static_cast<nbt_tag>(position[0]);
+		std::size_t name = detail::load_big_endian<std::uint16_t>(position + 1);
+		const byte_t * payload = position + 3 + name;
+		current = nbt_view(type, payload, payload_size(type, payload, last),
+			std::string_view(reinterpret_cast<const char *>(position + 3), name));
+	} else {
+		current = nbt_view(element, position, payload_size(element, position, last));
+	}
+}
+
+std::size_t nbt_view::encoded_size(bool named) const noexcept {
+	if (empty())
+		return 1;
+	return 1 + (named ? 2 + tag_name.size() : 0) + length;
+}
+
+std::string nbt_view::to_string() const {
+	std::string result;
+	append_snbt(result, *this);
+	return result;
+}
+
+bool operator==(const nbt_view & lhs, const nbt_view & rhs) noexcept {
+	return lhs.tag == rhs.tag && lhs.tag_name == rhs.tag_name && lhs.length == rhs.length
+		&& (lhs.length == 0 || std::memcmp(lhs.bytes, rhs.bytes, lhs.length) == 0);
+}
+
+int skip_nbt_payload(nbt_tag type, const byte_t bytes[], std::size_t length) noexcept {
+	return skip_payload(type, bytes, length, 0);
+}
+
+int try_read_nbt(nbt_view & view, const byte_t bytes[], std::size_t length, bool named) noexcept {
+	if (length < 1)
+		return -1;
+	if (bytes[0] >= tag_count)
+		return static_cast<int>(paket_errc::wrong_nbt);
+	nbt_tag type = static_cast<nbt_tag>(bytes[0]);
+	if (type == nbt_tag::end) {
+		view = nbt_view();
+		return 1;
+	}
+	std::size_t offset = 1;
+	std::string_view name;
+	if (named) {
+		if (length < 3)
+			return -1;
+		std::size_t size = detail::load_big_endian<std::uint16_t>(bytes + 1);
+		if (length - 3 < size)
+			return -1;
+		name = std::string_view(reinterpret_cast<const char *>(bytes + 3), size);
+		offset = 3 + size;
+	}
+	int s = skip_payload(type, bytes + offset, length - offset, 0);
+	if (s < 0)
+		return s;
+	view = nbt_view(type, bytes + offset, static_cast<std::size_t>(s), name);
+	return static_cast<int>(offset) + s;
+}
+
+int write_nbt(const nbt_view & view, byte_t bytes[], std::size_t length, bool named) noexcept {
+	std::size_t size = view.encoded_size(named);
+	if (length < size)
+		return -1;
+	bytes[0] = static_cast<byte_t>(view.type());
+	if (view.empty())
+		return 1;
+	std::size_t offset = 1;
+	if (named) {
+		detail::store_big_endian(bytes + 1, static_cast<std::uint16_t>(view.name().size()));
+		if (!view.name().empty())
+			std::memcpy(bytes + 3, view.name().data(), view.name().size());
+		offset = 3 + view.name().size();
+	}
+	std::memcpy(bytes + offset, view.payload().data(), view.payload().size());
+	return static_cast<int>(size);
+}
+
+} // namespace pakets
+
+} // namespace handtruth
@@ -0,0 +1,143 @@
+#include "paket_sink.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace handtruth {
+
+namespace pakets {
+
+byte_t * vector_sink::reserve(std::size_t size) {
+	std::size_t required = used + size;
+	if (storage.size() < required)
+		storage.resize(std::max(required, storage.size() * 2));
+	return storage.data() + used;
+}
+
+byte_t * chain_sink::reserve(std::size_t size) {
+	if (chain.empty() || chain.back().capacity - chain.back().used < size) {
+		std::size_t capacity = std::max(size, block_size);
+		chain.push_back({ std::unique_ptr<byte_t[]>(new byte_t[capacity]), capacity, 0 });
+	}
+	block & last = chain.back();
+	return last.memory.get() + last.used;
+}
+
+byte_t * chain_sink::locate(std::size_t position) noexcept {
+	for (block & each : chain) {
+		if (position < each.used)
+			return each.memory.get() + position;
+		position -= each.used;
+	}
+	return nullptr;
+}
+
+void chain_sink::rewind(std::size_t position) noexcept {
+	total = position;
+	for (std::size_t i = 0; i < chain.size(); ++i) {
+		if (position <= chain[i].used) {
+			chain[i].used = position;
+			chain.erase(chain.begin() + i + 1, chain.end());
+			return;
+		}
+		position -= chain[i].used;
+	}
+}
+
+std::vector<byte_span> chain_sink::blocks() const {
+	std::vector<byte_span> result;
+	result.reserve(chain.size());
+	for (const block & each : chain)
+		if (each.used != 0)
+			result.emplace_back(each.memory.get(), each.used);
+	return result;
+}
+
+std::vector<byte_t> chain_sink::collect() const {
+	std::vector<byte_t> result(total);
+	std::size_t offset = 0;
+	for (const block & each : chain) {
+		std::memcpy(result.data() + offset, each.memory.get(), each.used);
+		offset += each.used;
+	}
+	return result;
+}
+
+void chain_sink::clear() noexcept {
+	if (chain.size() > 1)
+		chain.erase(chain.begin() + 1, chain.end());
+	if (!chain.empty())
+		chain.front().used = 0;
+	total = 0;
+}
+
+byte_t * gather_sink::reserve(std::size_t size) {
+	std::size_t required = used + size;
+	if (scratch.size() < required)
+		scratch.resize(std::max(required, scratch.size() * 2));
+	return scratch.data() + used;
+}
+
+void gather_sink::commit(std::size_t size) {
+	if (size == 0)
+		return;
+	if (!pieces.empty() && pieces.back().external == nullptr)
+		pieces.back().size += size;
+	else
+		pieces.push_back({ nullptr, used, size });
+	used += size;
+	total += size;
+}
+
+void gather_sink::reference(const byte_t bytes[], std::size_t size) {
+	if (size < min_reference) {
+		if (size != 0)
+			std::memcpy(reserve(size), bytes, size);
+		commit(size);
+	} else {
+		pieces.push_back({ bytes, 0, size });
+		total += size;
+	}
+}
+
+byte_t * gather_sink::locate(std::size_t position) noexcept {
+	for (const piece & each : pieces) {
+		if (position < each.size)
+			return each.external == nullptr ? scratch.data() + each.offset + position : nullptr;
+		position -= each.size;
+	}
+	return nullptr;
+}
+
+void gather_sink::rewind(std::size_t position) noexcept {
+	total = position;
+	std::size_t i = 0;
+	while (i < pieces.size() && position > pieces[i].size)
+		position -= pieces[i++].size;
+	if (i < pieces.size()) {
+		pieces[i].size = position;
+		pieces.erase(pieces.begin() + (position == 0 ? i : i + 1), pieces.end());
+	}
+	// scratch is reused after the last piece that is still copied there
+	used = 0;
+	for (auto each = pieces.rbegin(); each != pieces.rend(); ++each) {
+		if (each->external == nullptr) {
+			used = each->offset + each->size;
+			break;
+		}
+	}
+}
+
+std::vector<io_slice> gather_sink::slices() const {
+	std::vector<io_slice> result;
+	result.reserve(pieces.size());
+	for (const piece & each : pieces) {
+		const byte_t * base = each.external == nullptr ? scratch.data() + each.offset : each.external;
+		result.push_back({ const_cast<byte_t *>(base), each.size });
+	}
+	return result;
+}
+
+} // namespace pakets
+
+} // namespace handtruth
@@ -0,0 +1,87 @@
+#include "paket_stream.hpp"
+
+#include <cstring>
+#include <algorithm>
+
+namespace handtruth {
+
+namespace pakets {
+
+paket_stream::paket_stream(std::size_t max_frame_size) : max_frame(max_frame_size) {}
+
+byte_t * paket_stream::prepare(std::size_t size) {
+	if (buffer.size() - last < size) {
+		if (first != 0) {
+			std::memmove(buffer.data(), buffer.data() + first, last - first);
+			last -= first;
+			scan -= first;
+			scan_end -= first;
+			first = 0;
+		}
+		std::size_t required = last + size;
+		if (buffer.size() < required)
+			buffer.resize(std::max(required, buffer.size() * 2));
+	}
+	return buffer.data() + last;
+}
+
+void paket_stream::commit(std::size_t size) {
+	last += size;
+	scan_frames();
+}
+
+void paket_stream::feed(const byte_t bytes[], std::size_t length) {
+	std::memcpy(prepare(length), bytes, length);
+	commit(length);
+}
+
+void paket_stream::scan_frames() {
+	for (;;) {
+		if (!scan_known) {
+			std::int32_t size;
+			int k = read_varint(size, buffer.data() + scan, last - scan);
+			if (k < 0)
+				return;
+			if (size <= 0 || static_cast<std::size_t>(size) > max_frame)
+				detail::raise("wrong frame size (" + std::to_string(size) + ")");
+			scan_end = scan + k + size;
+			scan_known = true;
+		}
+		if (scan_end > last)
+			return;
+		++frames;
+		scan = scan_end;
+		scan_known = false;
+	}
+}
+
+bool paket_stream::next(frame & result) {
+	if (frames == 0)
+		return false;
+	const byte_t * bytes = buffer.data() + first;
+	std::int32_t size;
+	int k = read_varint(size, bytes, last - first);
+	std::size_t frame_size = k + static_cast<std::size_t>(size);
+	// the frame is taken even if its id is malformed, so the stream can go on
+	int s = try_read_varnum(result.id, bytes + k, size);
+	first += frame_size;
+	--frames;
+	if (first == last && !scan_known)
+		first = last = scan = 0;
+	if (s == -1)
+		detail::raise("frame is too small for paket id");
+	if (s < 0)
+		detail::raise(static_cast<paket_errc>(s), k);
+	result.data = byte_span(bytes, frame_size);
+	result.body = byte_span(bytes + k + s, frame_size - k - s);
+	return true;
+}
+
+void paket_stream::clear() noexcept {
+	first = last = scan = scan_end = frames = 0;
+	scan_known = false;
+}
+
+} // namespace pakets
+
+} // namespace handtruth
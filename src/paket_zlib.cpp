@@ -0,0 +1,105 @@
+#include "paket_zlib.hpp"
+
+#include <zlib.h>
+
+namespace handtruth {
+
+namespace pakets {
+
+struct compression_codec::streams {
+	z_stream deflater {};
+	z_stream inflater {};
+
+	explicit streams(int level) {
+		if (deflateInit(&deflater, level) != Z_OK)
+			detail::raise("failed to initialize deflate stream");
+		if (inflateInit(&inflater) != Z_OK) {
+			deflateEnd(&deflater);
+			detail::raise("failed to initialize inflate stream");
+		}
+	}
+	~streams() {
+		deflateEnd(&deflater);
+		inflateEnd(&inflater);
+	}
+	streams(const streams &) = delete;
+	streams & operator=(const streams &) = delete;
+};
+
+compression_codec::compression_codec(std::size_t threshold, int level, std::size_t max_data_size)
+	: zlib(new streams(level)), limit(threshold), max_data(max_data_size) {}
+
+compression_codec::compression_codec(compression_codec &&) noexcept = default;
+compression_codec & compression_codec::operator=(compression_codec &&) noexcept = default;
+compression_codec::~compression_codec() = default;
+
+std::size_t compression_codec::bound(std::size_t size) const noexcept {
+	return deflateBound(&zlib->deflater, static_cast<uLong>(size));
+}
+
+std::size_t compression_codec::compress(const byte_t data[], std::size_t size, byte_t out[], std::size_t length) {
+	z_stream & stream = zlib->deflater;
+	deflateReset(&stream);
+	stream.next_in = const_cast<Bytef *>(data);
+	stream.avail_in = static_cast<uInt>(size);
+	stream.next_out = out;
+	stream.avail_out = static_cast<uInt>(length);
+	if (deflate(&stream, Z_FINISH) != Z_STREAM_END)
+		detail::raise("failed to compress paket");
+	return length - stream.avail_out;
+}
+
+void compression_codec::decompress(const byte_t data[], std::size_t size, byte_t out[], std::size_t length) {
+	z_stream & stream = zlib->inflater;
+	inflateReset(&stream);
+	stream.next_in = const_cast<Bytef *>(data);
+	stream.avail_in = static_cast<uInt>(size);
+	stream.next_out = out;
+	stream.avail_out = static_cast<uInt>(length);
+	if (inflate(&stream, Z_FINISH) != Z_STREAM_END || stream.avail_out != 0 || stream.avail_in != 0)
+		detail::raise("malformed compressed paket");
+}
+
+int compression_codec::read_frame(const byte_t bytes[], std::size_t length, frame & result, std::pmr::memory_resource * resource) {
+	std::int32_t size;
+	int k = read_varint(size, bytes, length);
+	if (k < 0)
+		return -1;
+	if (size <= 0)
+		detail::raise("wrong frame size (" + std::to_string(size) + ")");
+	std::size_t frame_size = k + static_cast<std::size_t>(size);
+	if (frame_size > length)
+		return -1;
+	std::int32_t data_size;
+	int d = read_varint(data_size, bytes + k, size);
+	if (d < 0)
+		detail::raise("frame is too small for data length");
+	const byte_t * data = bytes + k + d;
+	std::size_t data_length = static_cast<std::size_t>(size - d);
+	if (data_size != 0) {
+		if (data_size < 0 || static_cast<std::size_t>(data_size) < limit || static_cast<std::size_t>(data_size) > max_data)
+			detail::raise("wrong uncompressed paket size (" + std::to_string(data_size) + ")");
+		std::size_t usize = static_cast<std::size_t>(data_size);
+		byte_t * out;
+		if (resource != nullptr) {
+			out = static_cast<byte_t *>(resource->allocate(usize, 1));
+		} else {
+			if (inflated.size() < usize)
+				inflated.resize(usize);
+			out = inflated.data();
+		}
+		decompress(data, data_length, out, usize);
+		data = out;
+		data_length = usize;
+	}
+	int s = read_varint(result.id, data, data_length);
+	if (s < 0)
+		detail::raise("frame is too small for paket id");
+	result.data = byte_span(bytes, frame_size);
+	result.body = byte_span(data + s, data_length - s);
+	return static_cast<int>(frame_size);
+}
+
+} // namespace pakets
+
+} // namespace handtruth
@@ -0,0 +1,89 @@
+#include <paket_batch.hpp>
+
+#include "test.hpp"
+
+#include <random>
+#include <atomic>
+#include <thread>
+
+using namespace handtruth::pakets;
+
+struct message_paket : paket<3, fields::varint, fields::string> {};
+struct ping_paket : paket<4, fields::int64> {};
+
+test {
+	std::mt19937 random(5);
+	std::vector<byte_t> wire;
+	const int count = 5000;
+	for (int i = 0; i < count; ++i) {
+		byte_t bytes[200];
+		message_paket p;
+		p.field<0>() = i;
+		p.field<1>() = std::string(1 + random() % 150, 'a' + i % 26);
+		int size = p.write(bytes, sizeof(bytes));
+		wire.insert(wire.end(), bytes, bytes + size);
+	}
+	// incomplete frame at the end is left for the next batch
+	wire.push_back(10);
+	wire.push_back(3);
+
+	std::vector<frame> frames;
+	std::size_t taken = scan_frames(wire.data(), wire.size(), frames);
+	assert_equals(wire.size() - 2, taken);
+	assert_equals(std::size_t(count), frames.size());
+
+	batch_decoder decoder(4, 16);
+	assert_equals(4u, decoder.threads());
+	for (int round = 0; round < 3; ++round) {
+		auto pakets = decoder.decode_all<message_paket>(frames);
+		assert_equals(std::size_t(count), pakets.size());
+		for (int i = 0; i < count; ++i) {
+			assert_equals(i, pakets[i].field<0>());
+			assert_equals(std::string(1, 'a' + i % 26), pakets[i].field<1>().substr(0, 1));
+		}
+	}
+
+	auto ids = decoder.decode<std::int32_t>(frames, [](const frame & f) {
+		return f.id;
+	});
+	for (auto id : ids)
+		assert_equals(3, id);
+
+	// every index is visited exactly once, even when work is unbalanced
+	std::vector<std::atomic<int>> visits(10007);
+	decoder.parallel_for(visits.size(), [&visits](std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i) {
+			if (i < 500)
+				std::this_thread::yield();
+			visits[i].fetch_add(1);
+		}
+	});
+	for (auto & each : visits)
+		assert_equals(1, each.load());
+
+	batch_decoder single(1);
+	auto pakets = single.decode_all<message_paket>(frames);
+	assert_equals(count - 1, pakets.back().field<0>());
+
+	// frames of other pakets are reported
+	ping_paket ping;
+	ping.field<0>() = 7;
+	byte_t bytes[20];
+	int size = ping.write(bytes, sizeof(bytes));
+	frames.clear();
+	scan_frames(wire.data(), taken, frames);
+	std::vector<byte_t> other(wire.begin(), wire.begin() + taken);
+	other.insert(other.end(), bytes, bytes + size);
+	frames.clear();
+	assert_equals(other.size(), scan_frames(other.data(), other.size(), frames));
+	assert_equals(4, frames.back().id);
+	assert_fails_with(paket_error, {
+		decoder.decode_all<message_paket>(frames);
+	});
+
+	// malformed frame length
+	byte_t broken[] = { 0 };
+	assert_fails_with(paket_error, {
+		scan_frames(broken, sizeof(broken), frames);
+	});
+}
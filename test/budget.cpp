@@ -0,0 +1,51 @@
+#include <paket.hpp>
+
+#include "test.hpp"
+
+using namespace handtruth::pakets;
+
+struct names_paket : paket<9, fields::list<std::string>, fields::rest> {};
+
+test {
+	static_assert(fields::varint::min_size() == 1);
+	static_assert(fields::int64::min_size() == 8);
+	static_assert(fields::rest::min_size() == 0);
+
+	// huge count in 5 bytes must not be trusted before the data arrives
+	const byte_t hostile[] = { 0xff, 0xff, 0xff, 0xff, 0x07 };
+	fields::list<std::int64_t> longs;
+	assert_equals(-1, longs.read(hostile, sizeof(hostile)));
+	assert_true(longs.value.empty());
+	fields::list<std::uint16_t> shorts;
+	const byte_t few[] = { 3, 0, 1, 0, 2 };
+	assert_equals(-1, shorts.read(few, sizeof(few)));
+	assert_true(shorts.value.empty());
+
+	names_paket p;
+	p.field<0>() = { std::string("alice"), std::string("bob") };
+	p.field<1>() = { 1, 2, 3, 4 };
+	std::array<byte_t, 64> bytes;
+	int size = p.write(bytes);
+
+	names_paket q;
+	{
+		memory_budget budget(1024);
+		assert_equals(size, q.read(bytes, size));
+		assert_equals(p, q);
+		std::size_t spent = 2 * sizeof(fields::string) + 5 + 3 + 4;
+		assert_equals(1024 - spent, budget.remaining());
+		{
+			memory_budget inner(2 * sizeof(fields::string) + 6);
+			read_result result = q.try_read(bytes, size);
+			assert_true(paket_errc::budget_exceeded == result.error);
+			assert_equals(std::size_t(2), result.offset);
+			assert_fails_with(paket_error, {
+				q.read(bytes, size);
+			});
+		}
+		assert_equals(1024 - spent, budget.remaining());
+		budget.reset(2 * sizeof(fields::string) + 5 + 3);
+		assert_true(paket_errc::budget_exceeded == q.try_read(bytes, size).error);
+	}
+	assert_equals(size, q.read(bytes, size));
+}
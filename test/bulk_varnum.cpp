@@ -0,0 +1,93 @@
+#include <paket.hpp>
+
+#include "test.hpp"
+
+#include <random>
+#include <algorithm>
+
+using namespace handtruth::pakets;
+
+struct ids_paket : paket<19, fields::list<fields::varint>, fields::list<fields::varlong>,
+							fields::list<fields::zint<int>>, fields::list<fields::zint<std::int64_t>>> {};
+
+template <typename numeric>
+numeric random_value(std::mt19937_64 & random) {
+	// mostly small values like in real id lists
+	return static_cast<numeric>(random() >> (random() % 4 ? 58 : random() % 64));
+}
+
+test {
+	std::mt19937_64 random(7);
+	for (int round = 0; round < 200; ++round) {
+		ids_paket p1, p2;
+		std::size_t count = random() % 100;
+		for (std::size_t i = 0; i < count; ++i) {
+			p1.field<0>().emplace_back(random_value<std::int32_t>(random));
+			p1.field<1>().emplace_back(random_value<std::int64_t>(random));
+			p1.field<2>().emplace_back(random_value<int>(random));
+			p1.field<3>().emplace_back(random_value<std::int64_t>(random));
+		}
+		std::vector<byte_t> data(p1.size() + 10);
+		int size = p1.write(data.data(), data.size());
+		assert_true(size > 0);
+		assert_equals(size, p2.read(data.data(), data.size()));
+		assert_equals(p1, p2);
+		for (int cut = 0; cut < 8 && cut < size; ++cut)
+			assert_equals(-1, p2.read(data.data(), size - cut - 1));
+	}
+	std::vector<std::int32_t> values(1000);
+	std::vector<byte_t> encoded;
+	for (auto & each : values) {
+		each = random_value<std::int32_t>(random);
+		byte_t bytes[5];
+		int s = write_varint(each, bytes, sizeof(bytes));
+		encoded.insert(encoded.end(), bytes, bytes + s);
+	}
+	std::vector<std::int32_t> decoded(values.size());
+	assert_equals(int(encoded.size()), read_varint_bulk(decoded.data(), decoded.size(), encoded.data(), encoded.size()));
+	assert_true(values == decoded);
+	assert_equals(-1, read_varint_bulk(decoded.data(), decoded.size(), encoded.data(), encoded.size() - 1));
+	std::vector<byte_t> reencoded(encoded.size() + 8);
+	assert_equals(encoded.size(), size_varnum_bulk(values.data(), values.size()));
+	assert_equals(int(encoded.size()), write_varint_bulk(values.data(), values.size(), reencoded.data(), reencoded.size()));
+	assert_true(std::equal(encoded.begin(), encoded.end(), reencoded.begin()));
+	assert_equals(-1, write_varint_bulk(values.data(), values.size(), reencoded.data(), encoded.size() - 1));
+	for (int i = 0; i < 10000; ++i) {
+		auto value = static_cast<std::int64_t>(random() >> (random() % 64));
+		if (i % 2)
+			value = -value;
+		assert_equals(std::size_t(write_varnum(value, nullptr, 16)), size_varnum(value));
+		assert_equals(std::size_t(write_zint(value, nullptr, 16)), size_zint(value));
+		auto value32 = static_cast<std::int32_t>(value);
+		assert_equals(std::size_t(write_zint(value32, nullptr, 16)), size_zint(value32));
+	}
+	std::vector<std::int64_t> zvalues(1000);
+	std::vector<byte_t> zencoded;
+	for (auto & each : zvalues) {
+		each = random_value<std::int64_t>(random) * (random() % 2 ? 1 : -1);
+		byte_t bytes[10];
+		int s = write_zint(each, bytes, sizeof(bytes));
+		zencoded.insert(zencoded.end(), bytes, bytes + s);
+	}
+	std::vector<byte_t> zreencoded(zencoded.size() + 8);
+	assert_equals(zencoded.size(), size_zint_bulk(zvalues.data(), zvalues.size()));
+	assert_equals(int(zencoded.size()), write_zint_bulk(zvalues.data(), zvalues.size(), zreencoded.data(), zreencoded.size()));
+	assert_true(std::equal(zencoded.begin(), zencoded.end(), zreencoded.begin()));
+	assert_equals(10u, size_zint(std::numeric_limits<std::int64_t>::min()));
+	static_assert(size_zint(std::numeric_limits<std::int64_t>::min()) == 10);
+	static_assert(size_zint(std::numeric_limits<std::int32_t>::min()) == 5);
+	// magnitude of the minimum does not fit in the signed type
+	std::int64_t extremes[] = { std::numeric_limits<std::int64_t>::min(), std::numeric_limits<std::int32_t>::min(), -1, 0 };
+	std::array<byte_t, 32> extreme_bytes;
+	int extreme_size = write_zint_bulk(extremes, 4, extreme_bytes.data(), extreme_bytes.size());
+	assert_equals(int(size_zint_bulk(extremes, 4)), extreme_size);
+	std::int64_t extremes_back[4];
+	assert_equals(extreme_size, read_zint_bulk(extremes_back, 4, extreme_bytes.data(), extreme_bytes.size()));
+	assert_true(std::equal(extremes, extremes + 4, extremes_back));
+	assert_equals(5u, size_varint(std::numeric_limits<std::int32_t>::min()));
+	std::array<byte_t, 16> too_big;
+	too_big.fill(0xff);
+	assert_fails_with(paket_error, {
+		read_varint_bulk(decoded.data(), 1, too_big.data(), too_big.size());
+	});
+}
@@ -0,0 +1,149 @@
+#include <paket_capture.hpp>
+#include <paket_view.hpp>
+
+#include "test.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <algorithm>
+
+using namespace handtruth::pakets;
+
+struct message_paket : paket<3, fields::varint, fields::string> {};
+struct ping_paket : paket<4, fields::int64> {};
+
+test {
+	std::string path = "capture_test.pcap";
+	std::remove(path.c_str());
+	std::remove((path + ".idx").c_str());
+
+	const int count = 100;
+	{
+		capture_writer writer(path);
+		for (int i = 0; i < count; ++i) {
+			if (i % 3 == 0) {
+				ping_paket p;
+				p.field<0>() = i;
+				writer.record(p, direction::outbound, 7, 1000 + i * 10);
+			} else {
+				message_paket p;
+				p.field<0>() = i;
+				p.field<1>() = std::string(i, 'x');
+				writer.record(p, direction::inbound, i % 2, 1000 + i * 10);
+			}
+		}
+		assert_equals(std::uint64_t(count), writer.size());
+	}
+
+	{
+		capture_reader reader(path);
+		assert_equals(std::size_t(count), reader.size());
+		int i = 0;
+		for (capture_record record : reader) {
+			assert_equals(std::int64_t(1000 + i * 10), record.timestamp);
+			if (i % 3 == 0) {
+				assert_true(record.direction == direction::outbound);
+				assert_equals(7u, record.connection);
+				assert_equals(4, record.content.id);
+				ping_paket p;
+				assert_equals(int(record.content.data.size()), p.read(record.content.data.data(), record.content.data.size()));
+				assert_equals(std::int64_t(i), p.field<0>());
+			} else {
+				assert_true(record.direction == direction::inbound);
+				assert_equals(std::uint32_t(i % 2), record.connection);
+				paket_view<message_paket> view(record.content);
+				assert_equals(i, view.get<0>());
+				assert_equals(std::string(i, 'x'), view.get<1>());
+			}
+			++i;
+		}
+		assert_equals(count, i);
+
+		assert_equals(std::size_t(0), reader.lower_bound(0));
+		assert_equals(std::size_t(50), reader.lower_bound(1500));
+		assert_equals(std::size_t(51), reader.lower_bound(1501));
+		assert_equals(std::size_t(count), reader.lower_bound(100000));
+
+		auto pings = reader.find(4);
+		assert_equals(std::size_t(34), pings.size());
+		for (std::size_t each : pings) {
+			assert_equals(0u, each % 3);
+			assert_equals(4, reader.id(each));
+		}
+		const auto & messages = reader.find(3);
+		assert_equals(std::size_t(count - 34), messages.size());
+		assert_true(std::is_sorted(messages.begin(), messages.end()));
+		for (std::size_t each : messages)
+			assert_equals(3, reader[each].content.id);
+		assert_true(reader.find(5).empty());
+
+		int replayed = 0;
+		reader.replay([&](const capture_record & record) {
+			assert_equals(std::int64_t(1000 + (10 + replayed) * 10), record.timestamp);
+			++replayed;
+		}, 1000.0, 10, 20);
+		assert_equals(10, replayed);
+	}
+
+	// appending to the existing capture
+	{
+		capture_writer writer(path);
+		assert_equals(std::uint64_t(count), writer.size());
+		ping_paket p;
+		p.field<0>() = -1;
+		// older timestamp is clamped to keep the index ordered
+		writer.record(p, direction::inbound, 1, 5);
+		writer.flush();
+		capture_reader reader(path);
+		assert_equals(std::size_t(count + 1), reader.size());
+		assert_equals(std::int64_t(1000 + (count - 1) * 10), reader[count].timestamp);
+	}
+
+	// lost index is rebuilt from the capture
+	std::remove((path + ".idx").c_str());
+	{
+		capture_reader reader(path);
+		assert_equals(std::size_t(count + 1), reader.size());
+		assert_equals(3, reader[1].content.id);
+		assert_equals(std::size_t(34), reader.find(4).size() - 1);
+	}
+
+	// torn record at the end is ignored by the reader and dropped by the writer
+	{
+		std::ofstream out(path, std::ios::binary | std::ios::app);
+		const char torn[] = { 1, 2, 3, 4, 5, 6, 7, 8, 1, 0, 0, 0, 0, 0, 0, 0, 20, 3 };
+		out.write(torn, sizeof(torn));
+	}
+	{
+		capture_reader reader(path);
+		assert_equals(std::size_t(count + 1), reader.size());
+	}
+	{
+		capture_writer writer(path);
+		assert_equals(std::uint64_t(count + 1), writer.size());
+		message_paket p;
+		p.field<0>() = 42;
+		writer.record(p, direction::outbound, 3, 1 << 20);
+	}
+	{
+		capture_reader reader(path);
+		assert_equals(std::size_t(count + 2), reader.size());
+		paket_view<message_paket> view(reader[count + 1].content);
+		assert_equals(42, view.get<0>());
+		assert_equals(3u, reader.connection(count + 1));
+	}
+
+	capture_writer writer(path + ".other");
+	byte_t not_a_frame[] = { 5, 1 };
+	assert_fails_with(paket_error, {
+		writer.record(not_a_frame, sizeof(not_a_frame), direction::inbound);
+	});
+	assert_fails_with(paket_error, {
+		capture_reader reader("missing.pcap");
+	});
+
+	std::remove(path.c_str());
+	std::remove((path + ".idx").c_str());
+	std::remove((path + ".other").c_str());
+	std::remove((path + ".other.idx").c_str());
+}
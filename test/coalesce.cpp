@@ -0,0 +1,107 @@
+#include <paket_sink.hpp>
+
+#include "test.hpp"
+
+using namespace handtruth::pakets;
+
+// static runs at the start, in the middle and at the end of the paket
+struct movement_paket : paket<0x12, fields::int64, fields::int64, fields::int64, fields::boolean, fields::byte> {};
+struct mixed_paket : paket<0x13, fields::int32, fields::float32, fields::varint, fields::uint16,
+	fields::array<fields::int16, 3>, fields::boolean, fields::string, fields::uint64, fields::float64> {};
+struct single_paket : paket<0x14, fields::varint, fields::int32, fields::varint> {};
+
+static_assert(fields::static_run<fields::int64, fields::int64, fields::boolean>::count == 3);
+static_assert(fields::static_run<fields::int64, fields::int64, fields::boolean>::size == 17);
+static_assert(fields::static_run<fields::int32, fields::varint, fields::int64>::count == 1);
+static_assert(fields::static_run<fields::varint, fields::int64>::count == 0);
+static_assert(fields::static_run<fields::uint16, fields::array<fields::int16, 3>, fields::string>::size == 8);
+static_assert(fields::static_run<>::count == 0);
+
+// encodes fields one by one, as the paket did before static runs
+template <typename ...fields_t>
+std::vector<byte_t> encode_each(const fields_t &... fields) {
+	std::vector<byte_t> result;
+	auto append = [&result](const auto & field) {
+		std::vector<byte_t> bytes(field.size());
+		assert_equals(int(bytes.size()), field.write(bytes.data(), bytes.size()));
+		result.insert(result.end(), bytes.begin(), bytes.end());
+	};
+	(append(fields), ...);
+	return result;
+}
+
+template <std::int32_t id, typename ...fields_t>
+std::vector<byte_t> encode_body(const paket<id, fields_t...> & p) {
+	return std::apply([](const auto &... e) {
+		return encode_each(e...);
+	}, static_cast<const std::tuple<fields_t...> &>(p));
+}
+
+template <typename paket_t>
+void check(const paket_t & p) {
+	std::vector<byte_t> expected = encode_body(p);
+	assert_equals(expected.size(), p.size());
+
+	// body is at the end of the frame, so every shorter buffer cuts the body
+	std::vector<byte_t> frame(expected.size() + 10);
+	int size = p.write(frame.data(), frame.size());
+	assert_true(size > 0);
+	std::size_t head = size - expected.size();
+	assert_true(std::equal(expected.begin(), expected.end(), frame.begin() + head));
+	for (int length = 0; length < size; ++length)
+		assert_equals(-1, p.write(frame.data(), length));
+
+	// sink reserves the longest head first
+	std::vector<byte_t> from_sink(size + 10);
+	for (int length = 10; length < size; ++length) {
+		arena_sink small(from_sink.data(), length);
+		assert_equals(-1, p.write(small));
+	}
+	arena_sink sink(from_sink.data(), from_sink.size());
+	assert_equals(size, p.write(sink));
+	assert_true(std::equal(frame.begin(), frame.begin() + size, from_sink.begin()));
+
+	const byte_t * body = frame.data() + head;
+	for (std::size_t length = 0; length < expected.size(); ++length) {
+		paket_t decoded;
+		assert_true(decoded.try_read_body(body, length).error == paket_errc::incomplete);
+		assert_true(paket_t::skip_body(body, length).error == paket_errc::incomplete);
+	}
+	paket_t decoded;
+	read_result result = decoded.try_read_body(body, expected.size());
+	assert_true(result.ok());
+	assert_equals(expected.size(), result.offset);
+	assert_true(p == decoded);
+	assert_equals(expected.size(), paket_t::skip_body(body, expected.size()).offset);
+	assert_equals(size, paket_t::validate(frame.data(), size));
+}
+
+test {
+	movement_paket movement;
+	movement.field<0>() = 0x0000012345678000ll;
+	movement.field<1>() = -4096;
+	movement.field<2>() = 0x00000fedcba98000ll;
+	movement.field<3>() = true;
+	movement.field<4>() = 0x7f;
+	check(movement);
+
+	for (int i = 0; i < 50; ++i) {
+		mixed_paket mixed;
+		mixed.field<0>() = -i * 100003;
+		mixed.field<1>() = i * 0.5f;
+		mixed.field<2>() = i << (i % 25);
+		mixed.field<3>() = static_cast<std::uint16_t>(i * 1311);
+		mixed.field<4>() = { std::int16_t(i), std::int16_t(-i), std::int16_t(i * 300) };
+		mixed.field<5>() = i % 2 == 0;
+		mixed.field<6>() = std::string(i, 's');
+		mixed.field<7>() = 0xfedcba9876543210ull >> i;
+		mixed.field<8>() = -i / 3.0;
+		check(mixed);
+
+		single_paket single;
+		single.field<0>() = i;
+		single.field<1>() = -i;
+		single.field<2>() = i * 1000;
+		check(single);
+	}
+}
@@ -0,0 +1,200 @@
+#include <paket_decoder.hpp>
+#include <paket_nbt.hpp>
+
+#include "test.hpp"
+
+#include <random>
+#include <algorithm>
+
+using namespace handtruth::pakets;
+
+struct chunk_data_paket : paket<0x22, fields::int32, fields::int32, fields::list<fields::string>,
+	fields::packed_bits<4, 256>, fields::string, fields::rest> {};
+struct pack_paket : paket<0x3a, fields::varint, fields::string_view, fields::bytes_view> {};
+struct strict_paket : paket<0x3a, fields::varint, fields::string> {};
+struct small_paket : paket<0x3a, fields::varint> {};
+struct chat_paket : paket<15, fields::pmr::string, fields::pmr::list<std::string>, fields::pmr::rest> {};
+
+// such fields are rejected by paket_decoder, they would dangle after feed()
+static_assert(detail::refers_to_source<fields::list<std::string_view>>::value);
+static_assert(detail::refers_to_source<fields::list<fields::list<fields::bytes_view>>>::value);
+static_assert(detail::refers_to_source<fields::network_nbt>::value);
+static_assert(!detail::refers_to_source<fields::list<fields::string>>::value);
+
+chunk_data_paket make_chunk(std::mt19937 & random) {
+	chunk_data_paket chunk;
+	chunk.field<0>() = -7;
+	chunk.field<1>() = 12;
+	for (int i = 0; i < 20; ++i)
+		chunk.field<2>().emplace_back(std::string(random() % 40, 'a' + i));
+	for (std::size_t i = 0; i < 256; ++i)
+		chunk.field<3>()[i] = static_cast<std::uint16_t>(random() % 16);
+	chunk.field<4>() = std::string(3000, 'x');
+	for (int i = 0; i < 50000; ++i)
+		chunk.field<5>().push_back(static_cast<byte_t>(random()));
+	return chunk;
+}
+
+template <typename paket_t>
+std::vector<byte_t> encode(const paket_t & p) {
+	std::vector<byte_t> bytes(p.size() + 10);
+	bytes.resize(p.write(bytes.data(), bytes.size()));
+	return bytes;
+}
+
+// feeds chunks of random size up to max_chunk, checks that the carry buffer stays bounded
+template <typename paket_t>
+std::size_t feed_all(paket_decoder<paket_t> & decoder, const std::vector<byte_t> & bytes,
+		std::mt19937 & random, std::size_t max_chunk, std::size_t window) {
+	std::size_t offset = 0;
+	while (offset < bytes.size() && !decoder.done()) {
+		std::size_t chunk = std::min<std::size_t>(random() % (max_chunk + 1), bytes.size() - offset);
+		offset += decoder.feed(bytes.data() + offset, chunk);
+		assert_true(decoder.buffered() < window);
+		assert_equals(offset, decoder.consumed());
+	}
+	return offset;
+}
+
+test {
+	std::mt19937 random(3);
+	chunk_data_paket chunk = make_chunk(random);
+	std::vector<byte_t> bytes = encode(chunk);
+
+	// without handler everything is stored like paket::read() does
+	for (std::size_t max_chunk : { 1, 7, 300, 100000 }) {
+		paket_decoder<chunk_data_paket> decoder;
+		assert_equals(0u, decoder.expected());
+		assert_equals(bytes.size(), feed_all(decoder, bytes, random, max_chunk, decoder.default_window_size));
+		assert_true(decoder.done());
+		assert_equals(0u, decoder.expected());
+		assert_true(chunk == decoder.get());
+	}
+
+	// rest and long strings go to the handler, the window stays small
+	const std::size_t window = 256;
+	std::vector<byte_t> streamed;
+	std::string text;
+	paket_decoder<chunk_data_paket> decoder([&](std::size_t field, byte_span part) {
+		if (field == 5)
+			streamed.insert(streamed.end(), part.begin(), part.end());
+		else if (field == 4)
+			text.append(reinterpret_cast<const char *>(part.data()), part.size());
+		else
+			assert_true(false);
+	}, window);
+	for (std::size_t max_chunk : { 1, 13, 5000 }) {
+		streamed.clear();
+		text.clear();
+		decoder.reset();
+		assert_equals(bytes.size(), feed_all(decoder, bytes, random, max_chunk, window));
+		assert_true(decoder.done());
+		chunk_data_paket & decoded = decoder.get();
+		assert_equals(-7, decoded.field<0>());
+		assert_true(chunk.field<2>() == decoded.field<2>());
+		assert_true(chunk.field<3>() == decoded.field<3>());
+		assert_true(decoded.field<4>().empty());
+		assert_true(decoded.field<5>().empty());
+		assert_true(chunk.field<4>() == text);
+		assert_true(chunk.field<5>() == streamed);
+	}
+
+	// bytes of the next frame are not consumed
+	std::vector<byte_t> two = bytes;
+	two.insert(two.end(), bytes.begin(), bytes.end());
+	decoder.reset();
+	assert_equals(bytes.size(), decoder.feed(two.data(), two.size()));
+	assert_equals(0u, decoder.feed(two.data() + bytes.size(), bytes.size()));
+	decoder.reset();
+	assert_equals(bytes.size(), decoder.feed(two.data() + bytes.size(), bytes.size()));
+
+	// views are never stored
+	pack_paket pack;
+	pack.field<0>() = 1;
+	std::string hash(40, 'f');
+	pack.field<1>() = hash;
+	byte_t data[] = { 1, 2, 3 };
+	pack.field<2>() = byte_span(data, sizeof(data));
+	std::vector<byte_t> pack_bytes = encode(pack);
+	std::vector<std::size_t> fields;
+	paket_decoder<pack_paket> pack_decoder([&](std::size_t field, byte_span part) {
+		fields.insert(fields.end(), part.size(), field);
+	});
+	for (byte_t b : pack_bytes)
+		assert_equals(1u, pack_decoder.feed(&b, 1));
+	assert_true(pack_decoder.done());
+	assert_true(pack_decoder.get().field<1>().empty());
+	assert_equals(std::size_t(43), fields.size());
+	assert_equals(1u, fields[0]);
+	assert_equals(2u, fields[42]);
+
+	chat_paket chat;
+	chat.field<0>() = "hello";
+	chat.field<1>().emplace_back(std::pmr::string("first"));
+	chat.field<1>().emplace_back(std::pmr::string("second"));
+	chat.field<2>().assign(100, 7);
+	std::vector<byte_t> chat_bytes = encode(chat);
+	paket_decoder<chat_paket> chat_decoder({}, 16);
+	assert_equals(chat_bytes.size(), feed_all(chat_decoder, chat_bytes, random, 5, 16));
+	assert_true(chat == chat_decoder.get());
+
+	// frame ends inside a field
+	std::vector<byte_t> cut(pack_bytes.begin(), pack_bytes.begin() + 20);
+	cut[0] = 19;
+	paket_decoder<strict_paket> strict_decoder;
+	read_result result = strict_decoder.try_feed(cut.data(), 2);
+	assert_true(result.ok());
+	assert_equals(2u, result.offset);
+	result = strict_decoder.try_feed(cut.data() + 2, cut.size() - 2);
+	assert_true(result.error == paket_errc::wrong_size);
+	assert_equals(3u, result.offset);
+	// the failure sticks until reset
+	result = strict_decoder.try_feed(cut.data(), cut.size());
+	assert_true(result.error == paket_errc::wrong_size);
+	assert_fails_with(paket_error, {
+		strict_decoder.feed(cut.data(), cut.size());
+	});
+
+	// fields do not take the whole frame
+	paket_decoder<small_paket> small_decoder;
+	result = small_decoder.try_feed(pack_bytes.data(), pack_bytes.size());
+	assert_true(result.error == paket_errc::wrong_size);
+	assert_equals(3u, result.offset);
+
+	// other paket id
+	paket_decoder<chunk_data_paket> wrong;
+	result = wrong.try_feed(pack_bytes.data(), pack_bytes.size());
+	assert_true(result.error == paket_errc::wrong_id);
+	assert_equals(1u, result.offset);
+
+	// frame is too small for id
+	byte_t empty[] = { 0, 0x3a };
+	result = small_decoder.try_feed(empty, sizeof(empty));
+	assert_true(result.error == paket_errc::wrong_size);
+	small_decoder.reset();
+	result = small_decoder.try_feed(empty, sizeof(empty));
+	assert_true(result.error == paket_errc::wrong_frame);
+
+	// negative length
+	byte_t negative[] = { 7, 0x3a, 1, 0xff, 0xff, 0xff, 0xff, 0x0f };
+	strict_decoder.reset();
+	result = strict_decoder.try_feed(negative, sizeof(negative));
+	assert_true(result.error == paket_errc::negative_length);
+	assert_equals(3u, result.offset);
+
+	// field does not fit in the window
+	paket_decoder<chunk_data_paket> narrow({}, 64);
+	assert_equals(std::size_t(64), narrow.feed(bytes.data(), 64));
+	assert_fails_with(paket_error, {
+		for (std::size_t offset = 64; offset < bytes.size(); offset += 64)
+			narrow.feed(bytes.data() + offset, 64);
+	});
+
+	// memory budget is charged as contents arrive
+	paket_decoder<chunk_data_paket> limited;
+	{
+		memory_budget budget(10000);
+		result = limited.try_feed(bytes.data(), bytes.size());
+	}
+	assert_true(result.error == paket_errc::budget_exceeded);
+}
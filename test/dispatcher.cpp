@@ -0,0 +1,93 @@
+#include <paket_dispatcher.hpp>
+
+#include "test.hpp"
+
+using namespace handtruth::pakets;
+
+struct handshake_paket : paket<0, fields::varint, fields::string, fields::uint16, fields::varint> {};
+struct status_paket : paket<1> {};
+struct ping_paket : paket<2, fields::int64> {};
+struct far_paket : paket<100000, fields::string> {};
+
+struct visitor {
+	int handshakes = 0;
+	int statuses = 0;
+	std::int64_t ping = 0;
+	std::string far;
+	std::int32_t unknown = -1;
+	void operator()(const handshake_paket & p) {
+		++handshakes;
+		assert_equals("localhost", p.field<1>());
+	}
+	void operator()(const status_paket &) {
+		++statuses;
+	}
+	void operator()(const ping_paket & p) {
+		ping = p.field<0>();
+	}
+	void operator()(const far_paket & p) {
+		far = p.field<0>();
+	}
+	void operator()(std::int32_t id, byte_span) {
+		unknown = id;
+	}
+};
+
+test {
+	typedef paket_dispatcher<status_paket, handshake_paket, ping_paket> dense_dispatcher;
+	typedef paket_dispatcher<far_paket, ping_paket, handshake_paket> sparse_dispatcher;
+	static_assert(dense_dispatcher::index_of(0) == 1);
+	static_assert(dense_dispatcher::index_of(3) == 3);
+	static_assert(dense_dispatcher::index_of(-1) == 3);
+	static_assert(sparse_dispatcher::index_of(100000) == 0);
+	static_assert(sparse_dispatcher::index_of(2) == 1);
+	static_assert(!sparse_dispatcher::contains(1));
+
+	byte_t bytes[100];
+	std::size_t length = 0;
+	handshake_paket handshake;
+	handshake.field<0>() = 578;
+	handshake.field<1>() = "localhost";
+	handshake.field<2>() = 25565;
+	handshake.field<3>() = 1;
+	length += handshake.write(bytes + length, sizeof(bytes) - length);
+	length += status_paket().write(bytes + length, sizeof(bytes) - length);
+	ping_paket ping;
+	ping.field<0>() = 1234567;
+	length += ping.write(bytes + length, sizeof(bytes) - length);
+	far_paket far;
+	far.field<0>() = "far away";
+	length += far.write(bytes + length, sizeof(bytes) - length);
+
+	visitor v;
+	std::size_t offset = 0;
+	while (offset < length)
+		offset += dense_dispatcher::dispatch(bytes + offset, length - offset, v);
+	assert_equals(1, v.handshakes);
+	assert_equals(1, v.statuses);
+	assert_equals(1234567, v.ping);
+	assert_equals(100000, v.unknown);
+	assert_equals(-1, dense_dispatcher::dispatch(bytes, 3, v));
+
+	visitor w;
+	offset = 0;
+	while (offset < length)
+		offset += sparse_dispatcher::dispatch(bytes + offset, length - offset, w);
+	assert_equals(1, w.handshakes);
+	assert_equals(1, w.unknown);
+	assert_equals("far away", w.far);
+
+	auto only_pings = [](const auto &) {};
+	assert_fails_with(paket_error, {
+		paket_dispatcher<ping_paket>::dispatch(bytes, length, only_pings);
+	});
+	bytes[0] -= 1;
+	assert_fails_with(paket_error, {
+		dense_dispatcher::dispatch(bytes, length, v);
+	});
+	// negative frame length is malformed, not incomplete
+	const byte_t negative[] = { 0xff, 0xff, 0xff, 0xff, 0x0f, 0 };
+	assert_fails_with(paket_error, {
+		dense_dispatcher::dispatch(negative, sizeof(negative), v);
+	});
+}
@@ -0,0 +1,136 @@
+#include <paket.hpp>
+
+#include "test.hpp"
+
+using namespace handtruth::pakets;
+
+struct position_paket : paket<0x11, fields::int32, fields::uint32, fields::int16, fields::uint64, fields::float32, fields::float64> {};
+struct heightmap_paket : paket<0x12, fields::array<fields::int64, 37>, fields::list<fields::int32>, fields::list<double>> {};
+
+template <typename field_t>
+void check_bytes(const typename field_t::value_type & value, std::initializer_list<int> expected) {
+	byte_t bytes[16];
+	field_t field = value;
+	// odd offset checks that unaligned access is fine
+	assert_equals(int(expected.size()), field.write(bytes + 1, sizeof(bytes) - 1));
+	int i = 1;
+	for (int each : expected)
+		assert_equals(each, int(bytes[i++]));
+	field_t decoded = typename field_t::value_type();
+	assert_equals(int(expected.size()), decoded.read(bytes + 1, expected.size()));
+	assert_equals(value, decoded.value);
+	assert_equals(-1, decoded.try_read(bytes + 1, expected.size() - 1));
+}
+
+// encodes list elements one by one to compare with the bulk path
+template <typename field_t>
+void check_list(std::size_t count) {
+	fields::list<field_t> list;
+	std::vector<byte_t> expected;
+	byte_t count_bytes[5];
+	int k = write_varint(static_cast<std::int32_t>(count), count_bytes, sizeof(count_bytes));
+	expected.insert(expected.end(), count_bytes, count_bytes + k);
+	for (std::size_t i = 0; i < count; ++i) {
+		field_t element = static_cast<typename field_t::value_type>(0x0102030405060708ull * (i + 1) + i);
+		list.value.push_back(element);
+		byte_t bytes[8];
+		int s = element.write(bytes, sizeof(bytes));
+		expected.insert(expected.end(), bytes, bytes + s);
+	}
+	assert_equals(expected.size(), list.size());
+	std::vector<byte_t> bytes(expected.size() + 1);
+	assert_equals(int(expected.size()), list.write(bytes.data() + 1, expected.size()));
+	assert_true(std::equal(expected.begin(), expected.end(), bytes.begin() + 1));
+	fields::list<field_t> decoded;
+	assert_equals(int(expected.size()), decoded.read(bytes.data() + 1, expected.size()));
+	assert_equals(count, decoded.value.size());
+	for (std::size_t i = 0; i < count; ++i)
+		assert_equals(list.value[i].value, decoded.value[i].value);
+	if (count > 0)
+		assert_equals(-1, decoded.try_read(bytes.data() + 1, expected.size() - 1));
+}
+
+test {
+	check_bytes<fields::int16>(-2, { 0xff, 0xfe });
+	check_bytes<fields::uint16>(0x1234, { 0x12, 0x34 });
+	check_bytes<fields::int32>(0x01020304, { 1, 2, 3, 4 });
+	check_bytes<fields::int32>(-1, { 0xff, 0xff, 0xff, 0xff });
+	check_bytes<fields::uint32>(0xdeadbeef, { 0xde, 0xad, 0xbe, 0xef });
+	check_bytes<fields::int64>(-0x0102030405060708ll, { 0xfe, 0xfd, 0xfc, 0xfb, 0xfa, 0xf9, 0xf8, 0xf8 });
+	check_bytes<fields::uint64>(0x0102030405060708ull, { 1, 2, 3, 4, 5, 6, 7, 8 });
+	check_bytes<fields::float32>(1.0f, { 0x3f, 0x80, 0, 0 });
+	check_bytes<fields::float32>(-2.5f, { 0xc0, 0x20, 0, 0 });
+	check_bytes<fields::float64>(1.0, { 0x3f, 0xf0, 0, 0, 0, 0, 0, 0 });
+	check_bytes<fields::boolean>(true, { 1 });
+
+	// every tail length of the vectorized loops
+	for (std::size_t count = 0; count < 80; ++count) {
+		check_list<fields::uint16>(count);
+		check_list<fields::int16>(count);
+		check_list<fields::int32>(count);
+		check_list<fields::uint32>(count);
+		check_list<fields::int64>(count);
+		check_list<fields::uint64>(count);
+		check_list<fields::byte>(count);
+	}
+	check_list<fields::int64>(4096);
+
+	fields::list<float> floats;
+	floats.value = { 1.0f, -0.5f, 3.25f };
+	byte_t bytes[2000];
+	assert_equals(13, floats.write(bytes, sizeof(bytes)));
+	assert_equals(0x3f, int(bytes[1]));
+	assert_equals(0x80, int(bytes[2]));
+	fields::list<float> decoded_floats;
+	assert_equals(13, decoded_floats.read(bytes, 13));
+	assert_equals(3.25f, decoded_floats.value[2].value);
+
+	fields::list<bool> flags;
+	byte_t flag_bytes[] = { 3, 0, 1, 2 };
+	assert_equals(4, flags.read(flag_bytes, sizeof(flag_bytes)));
+	assert_false(flags.value[0].value);
+	assert_true(flags.value[1].value);
+	assert_true(flags.value[2].value);
+
+	fields::array<fields::uint16, 3> small;
+	small.value = { 1, 0x0203, 0xffff };
+	assert_equals(6u, small.size());
+	assert_equals(6, small.write(bytes, sizeof(bytes)));
+	assert_equals(2, int(bytes[2]));
+	assert_equals(-1, small.write(bytes, 5));
+	assert_equals(6, decltype(small)::skip(bytes, 6));
+	assert_equals(-1, decltype(small)::skip(bytes, 5));
+	fields::array<fields::uint16, 3> small_decoded;
+	assert_equals(6, small_decoded.read(bytes, 6));
+	assert_true(small.value == small_decoded.value);
+	assert_equals(std::string("[1, 515, 65535]"), std::string(small_decoded));
+
+	position_paket position;
+	position.field<0>() = -100;
+	position.field<1>() = 4000000000u;
+	position.field<2>() = -300;
+	position.field<3>() = 0xfedcba9876543210ull;
+	position.field<4>() = 0.1f;
+	position.field<5>() = -1e300;
+	assert_equals(4u + 4 + 2 + 8 + 4 + 8, position.size());
+	int size = position.write(bytes, sizeof(bytes));
+	position_paket position_decoded;
+	assert_equals(size, position_decoded.read(bytes, size));
+	assert_true(position == position_decoded);
+
+	heightmap_paket heightmap;
+	for (std::size_t i = 0; i < 37; ++i)
+		heightmap.field<0>()[i] = static_cast<std::int64_t>(i * 0x0101010101010101ull);
+	for (std::int32_t i = 0; i < 100; ++i)
+		heightmap.field<1>().emplace_back(i * 1000003);
+	heightmap.field<2>().emplace_back(0.5);
+	size = heightmap.write(bytes, sizeof(bytes));
+	// two bytes of frame length and one byte of paket id
+	assert_equals(int(heightmap.size()) + 3, size);
+	heightmap_paket heightmap_decoded;
+	assert_equals(size, heightmap_decoded.read(bytes, size));
+	assert_true(heightmap.field<0>() == heightmap_decoded.field<0>());
+	assert_equals(99 * 1000003, heightmap_decoded.field<1>()[99].value);
+	assert_equals(0.5, heightmap_decoded.field<2>()[0].value);
+	assert_equals(size, int(heightmap_paket::validate(bytes, size)));
+}
@@ -0,0 +1,52 @@
+#include <paket_sink.hpp>
+
+#include "test.hpp"
+
+using namespace handtruth::pakets;
+
+struct plugin_paket : paket<24, fields::string, fields::list<byte_t>, fields::string_view, fields::rest> {};
+
+std::vector<byte_t> concat(const std::vector<io_slice> & slices) {
+	std::vector<byte_t> result;
+	for (const auto & each : slices) {
+		auto bytes = static_cast<const byte_t *>(each.iov_base);
+		result.insert(result.end(), bytes, bytes + each.iov_len);
+	}
+	return result;
+}
+
+test {
+	plugin_paket p;
+	p.field<0>() = "minecraft:brand";
+	p.field<1>() = std::vector<fields::byte>(100, fields::byte(7));
+	std::string long_text(200, 't');
+	p.field<2>() = long_text;
+	p.field<3>().assign(1000, 0x42);
+	std::vector<byte_t> expected(p.size() + 10);
+	expected.resize(p.write(expected.data(), expected.size()));
+
+	gather_sink out(64);
+	assert_equals(int(expected.size()), p.write(out));
+	assert_equals(expected.size(), out.size());
+	auto slices = out.slices();
+	assert_true(concat(slices) == expected);
+	int references = 0;
+	for (const auto & each : slices) {
+		if (each.iov_base == p.field<3>().data() || each.iov_base == long_text.data()
+				|| each.iov_base == static_cast<const void *>(p.field<1>().data()))
+			++references;
+	}
+	assert_equals(3, references);
+
+	gather_sink copying(2000);
+	p.write(copying);
+	assert_equals(1u, copying.slices().size());
+	assert_true(concat(copying.slices()) == expected);
+
+	out.clear();
+	int size = p.write_once(out, length_encoding::padded3);
+	plugin_paket q;
+	auto bytes = concat(out.slices());
+	assert_equals(size, q.read(bytes.data(), bytes.size()));
+	assert_equals(p, q);
+}
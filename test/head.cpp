@@ -16,4 +16,17 @@ test {
 	assert_equals(1, size);
 	assert_equals(-1, head(bytes, 0, size, id));
 	assert_equals(-1, head(bytes, 1, size, id));
+
+	read_result result = try_head(bytes, buff_sz, size, id);
+	assert_true(result.ok());
+	assert_equals(std::size_t(1), result.offset);
+	assert_equals(42, id);
+	assert_true(paket_errc::incomplete == try_head(bytes, 1, size, id).error);
+	const byte_t long_id[] = { 6, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01 };
+	result = try_head(long_id, sizeof(long_id), size, id);
+	assert_true(paket_errc::varnum_too_big == result.error);
+	assert_equals(std::size_t(1), result.offset);
+	assert_fails_with(paket_error, {
+		head(long_id, sizeof(long_id), size, id);
+	});
 }
@@ -0,0 +1,178 @@
+#include <paket_nbt.hpp>
+
+#include "test.hpp"
+
+using namespace handtruth::pakets;
+
+struct slot_paket : paket<0x15, fields::varint, fields::nbt, fields::byte> {};
+struct entity_paket : paket<0x16, fields::network_nbt, fields::network_nbt> {};
+
+// appends NBT parts in big endian order
+struct nbt_builder {
+	std::vector<byte_t> bytes;
+
+	nbt_builder & raw(std::uint64_t value, int width) {
+		for (int i = width - 1; i >= 0; --i)
+			bytes.push_back(static_cast<byte_t>(value >> (8 * i)));
+		return *this;
+	}
+	nbt_builder & name(const std::string & text) {
+		raw(text.size(), 2);
+		bytes.insert(bytes.end(), text.begin(), text.end());
+		return *this;
+	}
+	nbt_builder & tag(nbt_tag type, const std::string & text) {
+		raw(static_cast<std::uint64_t>(type), 1);
+		return name(text);
+	}
+	nbt_builder & end() {
+		return raw(0, 1);
+	}
+};
+
+std::vector<byte_t> item_nbt() {
+	nbt_builder b;
+	b.tag(nbt_tag::compound, "item");
+	b.tag(nbt_tag::byte, "Count").raw(3, 1);
+	b.tag(nbt_tag::string, "id").name("minecraft:diamond_sword");
+	b.tag(nbt_tag::compound, "tag");
+		b.tag(nbt_tag::int32, "Damage").raw(5, 4);
+		b.tag(nbt_tag::list, "Enchantments").raw(static_cast<int>(nbt_tag::compound), 1).raw(2, 4);
+			b.tag(nbt_tag::string, "id").name("sharpness");
+			b.tag(nbt_tag::int16, "lvl").raw(std::uint16_t(-2), 2);
+			b.end();
+			b.tag(nbt_tag::string, "id").name("looting");
+			b.tag(nbt_tag::int16, "lvl").raw(3, 2);
+			b.end();
+		b.tag(nbt_tag::list, "Lore").raw(static_cast<int>(nbt_tag::string), 1).raw(2, 4).name("first").name("se\"cond");
+		b.end();
+	b.tag(nbt_tag::int_array, "Pos").raw(3, 4).raw(1, 4).raw(std::uint32_t(-2), 4).raw(3, 4);
+	b.tag(nbt_tag::long_array, "Seeds").raw(1, 4).raw(0x0102030405060708ull, 8);
+	b.tag(nbt_tag::byte_array, "Flags").raw(2, 4).raw(0x0107, 2);
+	b.tag(nbt_tag::list, "Speeds").raw(static_cast<int>(nbt_tag::float64), 1).raw(2, 4).raw(0x3ff8000000000000ull, 8).raw(0xc004000000000000ull, 8);
+	b.tag(nbt_tag::float32, "Scale").raw(0x3fc00000, 4);
+	b.tag(nbt_tag::int64, "Time").raw(1234567890123ull, 8);
+	b.tag(nbt_tag::list, "Empty").raw(0, 1).raw(0, 4);
+	b.tag(nbt_tag::compound, "my key").end();
+	b.end();
+	return b.bytes;
+}
+
+test {
+	std::vector<byte_t> nbt = item_nbt();
+
+	// validation alone does not decode anything
+	nbt_view root;
+	assert_equals(int(nbt.size()), try_read_nbt(root, nbt.data(), nbt.size(), true));
+	assert_true(root.type() == nbt_tag::compound);
+	assert_true(root.name() == "item");
+	assert_equals(std::size_t(11), root.size());
+
+	assert_equals(3, int(root["Count"].as_byte()));
+	assert_true(root["id"].as_string() == "minecraft:diamond_sword");
+	assert_equals(5, root["tag"]["Damage"].as_int32());
+	nbt_view enchantments = root["tag"]["Enchantments"];
+	assert_true(enchantments.element_type() == nbt_tag::compound);
+	assert_equals(std::size_t(2), enchantments.size());
+	assert_true(enchantments[1]["id"].as_string() == "looting");
+	assert_equals(-2, int(enchantments[0]["lvl"].as_int16()));
+	assert_true(root["tag"]["Lore"][1].as_string() == "se\"cond");
+	assert_equals(-2, root["Pos"][1].as_int32());
+	assert_equals(std::size_t(3), root["Pos"].size());
+	assert_equals(std::int64_t(0x0102030405060708ll), root["Seeds"][0].as_int64());
+	assert_equals(std::size_t(2), root["Flags"].as_bytes().size());
+	assert_equals(7, int(root["Flags"][1].as_byte()));
+	assert_equals(-2.5, root["Speeds"][1].as_float64());
+	assert_equals(1.5f, root["Scale"].as_float32());
+	assert_equals(std::int64_t(1234567890123ll), root["Time"].as_int64());
+	assert_equals(std::size_t(0), root["Empty"].size());
+	assert_true(root["Empty"].begin() == root["Empty"].end());
+	assert_equals(std::size_t(0), root["my key"].size());
+
+	// missing entries are empty and lookups can go on
+	assert_true(root["missing"].empty());
+	assert_true(root["missing"]["deeper"][3].empty());
+	assert_true(root["Pos"][3].empty());
+	assert_true(root["Count"]["x"].empty());
+	assert_fails_with(paket_error, {
+		root["Count"].as_int32();
+	});
+	assert_fails_with(paket_error, {
+		root["missing"].as_string();
+	});
+
+	int entries = 0;
+	for (const nbt_view & entry : root) {
+		assert_false(entry.name().empty());
+		++entries;
+	}
+	assert_equals(11, entries);
+
+	assert_equals(std::string("{Count:3b,id:\"minecraft:diamond_sword\",tag:{Damage:5,"
+		"Enchantments:[{id:\"sharpness\",lvl:-2s},{id:\"looting\",lvl:3s}],Lore:[\"first\",\"se\\\"cond\"]},"
+		"Pos:[I;1,-2,3],Seeds:[L;72623859790382856L],Flags:[B;1b,7b],Speeds:[1.500000d,-2.500000d],"
+		"Scale:1.500000f,Time:1234567890123L,Empty:[],\"my key\":{}}"), root.to_string());
+
+	// paket keeps the view and writes it back unchanged
+	slot_paket slot;
+	slot.field<0>() = 36;
+	slot.field<1>() = root;
+	slot.field<2>() = 1;
+	std::vector<byte_t> frame(slot.size() + 10);
+	int size = slot.write(frame.data(), frame.size());
+	assert_equals(size, int(slot_paket::validate(frame.data(), size)));
+	slot_paket decoded;
+	assert_equals(size, decoded.read(frame.data(), size));
+	assert_true(slot == decoded);
+	assert_true(decoded.field<1>().payload().data() != nbt.data());
+	assert_equals(5, decoded.field<1>()["tag"]["Damage"].as_int32());
+	std::vector<byte_t> again(frame.size());
+	assert_equals(size, decoded.write(again.data(), again.size()));
+	assert_true(std::equal(frame.begin(), frame.begin() + size, again.begin()));
+	for (int length = 0; length < size; ++length)
+		assert_equals(-1, decoded.write(again.data(), length));
+
+	// the same tag without name, and missing NBT as single TAG_End
+	entity_paket entity;
+	entity.field<0>() = root["tag"];
+	size = entity.write(frame.data(), frame.size());
+	entity_paket entity_decoded;
+	assert_equals(size, entity_decoded.read(frame.data(), size));
+	assert_true(entity_decoded.field<0>().name().empty());
+	assert_equals(5, entity_decoded.field<0>()["Damage"].as_int32());
+	assert_true(entity_decoded.field<1>().empty());
+	assert_equals(std::string(""), std::string(entity_decoded.wrapper<1>()));
+	assert_equals(1u, entity_decoded.wrapper<1>().size());
+
+	// every cut is incomplete
+	for (std::size_t length = 0; length < nbt.size(); ++length) {
+		nbt_view view;
+		assert_equals(-1, try_read_nbt(view, nbt.data(), length, true));
+		assert_equals(-1, fields::nbt::skip(nbt.data(), length));
+	}
+
+	nbt_builder unknown;
+	unknown.tag(nbt_tag::compound, "").raw(13, 1).name("x").end();
+	assert_equals(int(paket_errc::wrong_nbt), fields::nbt::skip(unknown.bytes.data(), unknown.bytes.size()));
+
+	nbt_builder negative;
+	negative.tag(nbt_tag::int_array, "").raw(std::uint32_t(-1), 4);
+	assert_equals(int(paket_errc::negative_length), fields::nbt::skip(negative.bytes.data(), negative.bytes.size()));
+
+	nbt_builder end_list;
+	end_list.tag(nbt_tag::list, "").raw(0, 1).raw(1, 4);
+	assert_equals(int(paket_errc::wrong_nbt), fields::nbt::skip(end_list.bytes.data(), end_list.bytes.size()));
+
+	// nesting is limited before the stack is
+	nbt_builder deep;
+	deep.raw(static_cast<int>(nbt_tag::list), 1);
+	for (int i = 0; i < 600; ++i)
+		deep.raw(static_cast<int>(nbt_tag::list), 1).raw(1, 4);
+	deep.raw(0, 1).raw(0, 4);
+	assert_equals(int(paket_errc::wrong_nbt), fields::network_nbt::skip(deep.bytes.data(), deep.bytes.size()));
+
+	fields::nbt field;
+	assert_fails_with(paket_error, {
+		field.read(unknown.bytes.data(), unknown.bytes.size());
+	});
+}
@@ -0,0 +1,127 @@
+#include <paket.hpp>
+
+#include "test.hpp"
+
+#include <random>
+
+using namespace handtruth::pakets;
+
+struct chunk_section_paket : paket<0x20, fields::int16, fields::byte, fields::packed_bits<15, 4096>,
+	fields::byte, fields::packed_bits<3, 64, bit_packing::spanning, std::uint32_t>> {};
+
+// sets bits one by one, the slowest but the most obvious way
+std::vector<byte_t> pack_reference(const std::vector<std::uint32_t> & entries, unsigned bits, bit_packing packing) {
+	std::vector<std::uint64_t> words(detail::packed_words(entries.size(), bits, packing));
+	std::size_t per_word = 64 / bits;
+	for (std::size_t i = 0; i < entries.size(); ++i) {
+		std::size_t first = packing == bit_packing::padded ? i / per_word * 64 + i % per_word * bits : i * bits;
+		for (unsigned b = 0; b < bits; ++b)
+			if (entries[i] >> b & 1)
+				words[(first + b) / 64] |= std::uint64_t(1) << (first + b) % 64;
+	}
+	std::vector<byte_t> bytes(words.size() * 8);
+	for (std::size_t w = 0; w < words.size(); ++w)
+		for (int k = 0; k < 8; ++k)
+			bytes[w * 8 + k] = static_cast<byte_t>(words[w] >> (56 - 8 * k));
+	return bytes;
+}
+
+template <typename index_t>
+void check(std::mt19937 & random, std::size_t count, unsigned bits, bit_packing packing) {
+	std::vector<std::uint32_t> entries(count);
+	std::vector<index_t> source(count);
+	for (std::size_t i = 0; i < count; ++i) {
+		entries[i] = static_cast<std::uint32_t>(random() & ((std::uint64_t(1) << bits) - 1));
+		// high bits should be ignored
+		source[i] = static_cast<index_t>(entries[i] | (random() << bits));
+	}
+	std::vector<byte_t> expected = pack_reference(entries, bits, packing);
+	// guard bytes catch writes past the end
+	std::vector<byte_t> bytes(expected.size() + 16, 0xaa);
+	detail::pack_bits(bytes.data(), source.data(), count, bits, packing);
+	assert_true(std::equal(expected.begin(), expected.end(), bytes.begin()));
+	for (std::size_t i = expected.size(); i < bytes.size(); ++i)
+		assert_equals(0xaa, int(bytes[i]));
+
+	std::vector<index_t> decoded(count + 8, 0x5555);
+	detail::unpack_bits(decoded.data(), count, expected.data(), bits, packing);
+	for (std::size_t i = 0; i < count; ++i)
+		assert_equals(entries[i], std::uint32_t(decoded[i]));
+	for (std::size_t i = count; i < decoded.size(); ++i)
+		assert_equals(0x5555u, unsigned(decoded[i]));
+}
+
+test {
+	std::mt19937 random(5);
+	const std::size_t counts[] = { 0, 1, 7, 63, 64, 65, 255, 256, 300, 1000, 4096, 4099 };
+	for (bit_packing packing : { bit_packing::padded, bit_packing::spanning }) {
+		for (std::size_t count : counts) {
+			for (unsigned bits = 1; bits <= 16; ++bits) {
+				check<std::uint16_t>(random, count, bits, packing);
+				check<std::uint32_t>(random, count, bits, packing);
+			}
+			for (unsigned bits = 17; bits <= 32; ++bits)
+				check<std::uint32_t>(random, count, bits, packing);
+		}
+	}
+
+	assert_equals(256u, detail::packed_words(4096, 4, bit_packing::padded));
+	assert_equals(342u, detail::packed_words(4096, 5, bit_packing::padded));
+	assert_equals(320u, detail::packed_words(4096, 5, bit_packing::spanning));
+
+	chunk_section_paket section;
+	section.field<0>() = 1234;
+	section.field<1>() = 15;
+	for (std::size_t i = 0; i < 4096; ++i)
+		section.field<2>()[i] = static_cast<std::uint16_t>(i * 7919 % 32768);
+	section.field<3>() = 3;
+	for (std::size_t i = 0; i < 64; ++i)
+		section.field<4>()[i] = i % 8;
+	using blocks_t = chunk_section_paket::field_type<2>;
+	static_assert(blocks_t::words() == 1024);
+	assert_equals(2u + 1024 * 8, blocks_t::size());
+	assert_equals(1u + 24, chunk_section_paket::field_type<4>::size());
+
+	std::vector<byte_t> bytes(section.size() + 10);
+	int size = section.write(bytes.data(), bytes.size());
+	assert_equals(size, int(chunk_section_paket::validate(bytes.data(), size)));
+	chunk_section_paket decoded;
+	assert_equals(size, decoded.read(bytes.data(), size));
+	assert_true(section == decoded);
+	assert_equals(-1, decoded.read(bytes.data(), size - 1));
+
+	// the same bytes are a list of longs
+	fields::list<fields::int64> longs;
+	std::size_t body = size - int(section.size());
+	assert_equals(2 + 1024 * 8, longs.read(bytes.data() + body + 3, size - body - 3));
+	assert_equals(std::size_t(1024), longs.value.size());
+	std::int64_t first = 0;
+	for (int k = 0; k < 4; ++k)
+		first |= std::int64_t(section.field<2>()[k]) << (k * 15);
+	assert_equals(first, longs.value[0].value);
+
+	// count of longs should match
+	blocks_t blocks;
+	byte_t wrong[16] = { 0x80, 0x07 };
+	assert_equals(int(paket_errc::wrong_size), blocks.try_read(wrong, sizeof(wrong)));
+	assert_equals(int(paket_errc::wrong_size), blocks_t::skip(wrong, sizeof(wrong)));
+	byte_t negative[] = { 0xff, 0xff, 0xff, 0xff, 0x0f };
+	assert_equals(int(paket_errc::negative_length), blocks.try_read(negative, sizeof(negative)));
+	byte_t truncated[] = { 0x80, 0x08, 0, 0 };
+	assert_equals(-1, blocks.try_read(truncated, sizeof(truncated)));
+	assert_fails_with(paket_error, {
+		blocks.read(wrong, sizeof(wrong));
+	});
+
+	// count of longs encoded longer than needed
+	byte_t padded_count[] = { 0x81, 0x00, 0, 0, 0, 0, 0, 0, 0x32, 0x10 };
+	fields::packed_bits<4, 16> small;
+	fields::list<fields::int64> one_long;
+	assert_equals(10, one_long.read(padded_count, sizeof(padded_count)));
+	assert_equals(10, small.read(padded_count, sizeof(padded_count)));
+	assert_equals(10, decltype(small)::skip(padded_count, sizeof(padded_count)));
+	assert_equals(0, int(small.value[0]));
+	assert_equals(1, int(small.value[1]));
+	assert_equals(3, int(small.value[3]));
+	assert_equals(-1, small.try_read(padded_count, sizeof(padded_count) - 1));
+}
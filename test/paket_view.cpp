@@ -0,0 +1,65 @@
+#include <paket_view.hpp>
+
+#include "test.hpp"
+
+using namespace handtruth::pakets;
+
+struct chat_paket : paket<15, fields::varint, fields::string, fields::list<fields::varint>, fields::int64> {};
+
+test {
+	chat_paket p;
+	p.field<0>() = 300;
+	p.field<1>() = "hello there";
+	p.field<2>() = { 1, -1, 70000 };
+	p.field<3>() = -42;
+	std::array<byte_t, 64> bytes;
+	int size = p.write(bytes);
+
+	paket_view<chat_paket> view;
+	assert_equals(-1, view.read(bytes.data(), size - 1));
+	// negative frame length never completes
+	byte_t negative[] = { 0xff, 0xff, 0xff, 0xff, 0x0f, 15 };
+	assert_fails_with(paket_error, {
+		view.read(negative, sizeof(negative));
+	});
+	assert_equals(size, view.read(bytes, size));
+	assert_equals(std::size_t(size - 2), view.body().size());
+	assert_equals(300, view.get<0>());
+	assert_equals(-42, view.get<3>());
+	assert_equals("hello there", view.get<1>());
+	assert_equals(std::size_t(2 + 12), view.offset<2>());
+	auto list = view.get<2>();
+	assert_equals(std::size_t(3), list.size());
+	assert_equals(70000, list[2].value);
+	assert_equals(std::size_t(2), view.data<0>().size());
+	view.validate();
+	chat_paket copy;
+	view.to(copy);
+	assert_equals(p, copy);
+
+	frame f;
+	f.id = 15;
+	f.body = view.body();
+	paket_view<chat_paket> framed(f);
+	fields::string text;
+	framed.get<1>(text);
+	assert_equals("hello there", text.value);
+	f.id = 16;
+	assert_fails_with(paket_error, {
+		paket_view<chat_paket> other(f);
+	});
+
+	// body is cut inside the list, so fields after it are missing
+	paket_view<chat_paket> cut(view.body().data(), 16);
+	assert_equals("hello there", cut.get<1>());
+	assert_fails_with(paket_error, {
+		cut.get<3>();
+	});
+	// extra byte after the last field
+	bytes[size] = 0;
+	paket_view<chat_paket> longer(view.body().data(), view.body().size() + 1);
+	assert_equals(-42, longer.get<3>());
+	assert_fails_with(paket_error, {
+		longer.validate();
+	});
+}
@@ -0,0 +1,47 @@
+#include <paket.hpp>
+
+#include "test.hpp"
+
+#include <memory_resource>
+
+using namespace handtruth::pakets;
+
+struct chat_paket : paket<15, fields::varint, fields::pmr::string, fields::pmr::list<std::string>,
+							fields::pmr::list<std::int32_t>, fields::pmr::rest> {
+	using paket::paket;
+};
+
+struct plain_chat_paket : paket<15, fields::varint, fields::string, fields::list<std::string>,
+								fields::list<std::int32_t>, fields::rest> {};
+
+test {
+	plain_chat_paket source;
+	source.field<0>() = 12;
+	source.field<1>() = std::string(100, 'm');
+	source.field<2>() = { fields::string(std::string(50, 'a')), fields::string(std::string(60, 'b')) };
+	source.field<3>() = { fields::varint(1), fields::varint(300), fields::varint(-5) };
+	source.field<4>().assign(200, 9);
+	byte_t bytes[1000];
+	int size = source.write(bytes, sizeof(bytes));
+
+	alignas(std::max_align_t) static byte_t arena[8192];
+	// any allocation outside of the arena fails with null upstream
+	std::pmr::monotonic_buffer_resource resource(arena, sizeof(arena), std::pmr::null_memory_resource());
+	std::pmr::polymorphic_allocator<byte_t> alloc(&resource);
+	for (int i = 0; i < 5; ++i) {
+		chat_paket p(std::allocator_arg, alloc);
+		assert_true(p.field<1>().get_allocator().resource() == &resource);
+		assert_equals(size, p.read(bytes, size));
+		assert_true(p.field<2>()[1].value.get_allocator().resource() == &resource);
+		assert_equals(std::string(100, 'm'), std::string(p.field<1>()));
+		assert_equals(std::string(60, 'b'), std::string(p.field<2>()[1].value));
+		assert_equals(300, p.field<3>()[1].value);
+		assert_equals(200u, p.field<4>().size());
+		assert_equals(source.size(), p.size());
+		byte_t copy[1000];
+		assert_equals(size, p.write(copy, sizeof(copy)));
+		assert_true(std::equal(bytes, bytes + size, copy));
+		assert_equals(std::to_string(source), std::to_string(p));
+	}
+	resource.release();
+}
@@ -0,0 +1,88 @@
+#include <paket_sink.hpp>
+
+#include "test.hpp"
+
+#include <algorithm>
+
+using namespace handtruth::pakets;
+
+struct chunk_paket : paket<32, fields::int64, fields::varint, fields::list<fields::varint>, fields::list<std::string>,
+							fields::zint<int>, fields::string_view, fields::rest> {};
+
+chunk_paket make_paket(int i) {
+	chunk_paket p;
+	p.field<0>() = i * 1000003;
+	p.field<1>() = -i;
+	for (int k = 0; k < i % 50; ++k) {
+		p.field<2>().emplace_back(k * i);
+		p.field<3>().emplace_back(std::string(k, 'x'));
+	}
+	p.field<4>() = -i * 7;
+	p.field<5>() = "view";
+	p.field<6>().assign(i % 300, byte_t(i));
+	return p;
+}
+
+test {
+	const int count = 500;
+	std::vector<byte_t> expected;
+	vector_sink out;
+	chain_sink chain(256);
+	for (int i = 0; i < count; ++i) {
+		chunk_paket p = make_paket(i);
+		std::vector<byte_t> bytes(p.size() + 10);
+		int size = p.write(bytes.data(), bytes.size());
+		expected.insert(expected.end(), bytes.begin(), bytes.begin() + size);
+		assert_equals(size, p.write(out));
+		assert_equals(size, p.write(chain));
+	}
+	assert_equals(expected.size(), out.size());
+	assert_true(std::equal(expected.begin(), expected.end(), out.data()));
+	assert_true(expected == chain.collect());
+	assert_true(chain.blocks().size() > 1);
+
+	std::size_t offset = 0;
+	for (int i = 0; i < count; ++i) {
+		chunk_paket p;
+		std::int32_t frame_size, id;
+		int k = head(out.data() + offset, out.size() - offset, frame_size, id);
+		offset += p.read(out.data() + offset, k + frame_size);
+		assert_equals(make_paket(i), p);
+	}
+
+	byte_t small[40];
+	arena_sink arena(small, sizeof(small));
+	assert_equals(-1, make_paket(20).write(arena));
+	// failed write does not leave a partial frame
+	assert_equals(0u, arena.size());
+	arena.clear();
+	int size = make_paket(1).write(arena);
+	assert_true(size > 0);
+	assert_equals(std::size_t(size), arena.size());
+	out.clear();
+	assert_equals(0u, out.size());
+
+	// rewind drops frames written after the position
+	chunk_paket first = make_paket(299);
+	chunk_paket second = make_paket(149);
+	std::vector<byte_t> twice(first.size() + 10);
+	twice.resize(first.write(twice.data(), twice.size()));
+	twice.insert(twice.end(), twice.begin(), twice.end());
+	chain_sink rewound(256);
+	gather_sink gather(16);
+	for (int k = 0; k < 2; ++k) {
+		first.write(rewound);
+		first.write(gather);
+		std::size_t mark = rewound.position();
+		second.write(rewound);
+		second.write(gather);
+		rewound.rewind(mark);
+		gather.rewind(mark);
+		assert_equals(mark, gather.size());
+	}
+	assert_true(twice == rewound.collect());
+	std::vector<byte_t> gathered;
+	for (const io_slice & slice : gather.slices())
+		gathered.insert(gathered.end(), static_cast<byte_t *>(slice.iov_base), static_cast<byte_t *>(slice.iov_base) + slice.iov_len);
+	assert_true(twice == gathered);
+}
@@ -0,0 +1,74 @@
+#include <paket.hpp>
+
+#include "test.hpp"
+
+using namespace handtruth::pakets;
+
+struct mixed_paket : paket<7, fields::varint, fields::varlong, fields::zint<std::int64_t>, fields::string,
+		fields::list<std::uint16_t>, fields::list<std::string>, fields::boolean, fields::rest> {};
+struct empty_paket : paket<8> {};
+
+template <typename field_t>
+void check_skip(const field_t & field) {
+	std::array<byte_t, 64> bytes;
+	int size = field.write(bytes.data(), bytes.size());
+	assert_true(size > 0);
+	assert_equals(size, field_t::skip(bytes.data(), size));
+	assert_equals(size, field_t::skip(bytes.data(), bytes.size()));
+	if constexpr (!std::is_same_v<field_t, fields::rest>)
+		assert_equals(-1, field_t::skip(bytes.data(), size - 1));
+}
+
+test {
+	check_skip(fields::varint(0));
+	check_skip(fields::varint(-1));
+	check_skip(fields::varlong(300));
+	check_skip(fields::varlong(-1));
+	check_skip(fields::zint<std::int32_t>(-70000));
+	check_skip(fields::string("some text"));
+	check_skip(fields::string_view("some text"));
+	check_skip(fields::int64(5));
+	fields::list<std::int64_t> longs;
+	longs.value = { 1, -1, 1ll << 40 };
+	check_skip(longs);
+	fields::list<std::uint16_t> shorts;
+	shorts.value = { 1, 2, 3 };
+	check_skip(shorts);
+
+	// 8 bytes with continuation bit are too much for varint, but not for varlong
+	std::array<byte_t, 12> long_varnum;
+	long_varnum.fill(0xff);
+	long_varnum[9] = 0x01;
+	assert_equals(10, fields::varlong::skip(long_varnum.data(), long_varnum.size()));
+	assert_equals(-1, fields::varlong::skip(long_varnum.data(), 9));
+	assert_equals(int(paket_errc::varnum_too_big), fields::varint::skip(long_varnum.data(), long_varnum.size()));
+	assert_equals(int(paket_errc::varnum_too_big), fields::varint::skip(long_varnum.data(), 6));
+
+	mixed_paket p;
+	p.field<0>() = 12;
+	p.field<1>() = -5;
+	p.field<2>() = -123456789;
+	p.field<3>() = "hello";
+	p.field<4>() = { 1, 2, 3, 4 };
+	p.field<5>() = { std::string("a"), std::string("bc"), std::string() };
+	p.field<6>() = true;
+	p.field<7>() = { 9, 8, 7 };
+	std::array<byte_t, 128> bytes;
+	int size = p.write(bytes);
+	assert_equals(p.size(), mixed_paket::skip_body(bytes.data() + 2, size - 2).offset);
+	assert_equals(size, mixed_paket::validate(bytes, size + 10));
+	assert_equals(-1, mixed_paket::validate(bytes, size - 1));
+	assert_fails_with(paket_error, {
+		empty_paket::validate(bytes, size);
+	});
+
+	// frame ends in the middle of the paket body
+	bytes[0] = static_cast<byte_t>(bytes[0] - 6);
+	assert_fails_with(paket_error, {
+		mixed_paket::validate(bytes, size);
+	});
+
+	empty_paket empty;
+	size = empty.write(bytes);
+	assert_equals(size, empty_paket::validate(bytes, size));
+}
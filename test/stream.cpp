@@ -0,0 +1,97 @@
+#include <paket_stream.hpp>
+
+#include "test.hpp"
+
+#include <random>
+#include <algorithm>
+
+using namespace handtruth::pakets;
+
+struct message_paket : paket<3, fields::varint, fields::string> {};
+struct ping_paket : paket<4, fields::int64> {};
+
+test {
+	std::mt19937 random(1);
+	std::vector<byte_t> wire;
+	const int count = 300;
+	for (int i = 0; i < count; ++i) {
+		byte_t bytes[200];
+		int size;
+		if (i % 2) {
+			ping_paket p;
+			p.field<0>() = i;
+			size = p.write(bytes, sizeof(bytes));
+		} else {
+			message_paket p;
+			p.field<0>() = i;
+			p.field<1>() = std::string(random() % 150, 'a');
+			size = p.write(bytes, sizeof(bytes));
+		}
+		wire.insert(wire.end(), bytes, bytes + size);
+	}
+	paket_stream stream;
+	int received = 0;
+	std::size_t offset = 0;
+	while (offset < wire.size()) {
+		std::size_t chunk = std::min<std::size_t>(random() % 40, wire.size() - offset);
+		std::copy(wire.begin() + offset, wire.begin() + offset + chunk, stream.prepare(chunk));
+		stream.commit(chunk);
+		offset += chunk;
+		frame f;
+		while (stream.next(f)) {
+			if (received % 2) {
+				assert_equals(4, f.id);
+				ping_paket p;
+				assert_equals(int(f.data.size()), p.read(f.data.data(), f.data.size()));
+				assert_equals(received, int(p.field<0>()));
+				assert_equals(8u, f.body.size());
+			} else {
+				assert_equals(3, f.id);
+				message_paket p;
+				assert_equals(int(f.data.size()), p.read(f.data.data(), f.data.size()));
+				assert_equals(received, p.field<0>());
+			}
+			++received;
+		}
+		assert_equals(0u, stream.pending());
+	}
+	assert_equals(count, received);
+	assert_equals(0u, stream.buffered());
+
+	const byte_t two_frames[] = { 2, 4, 1, 2, 5 };
+	stream.feed(two_frames, sizeof(two_frames));
+	assert_equals(1u, stream.pending());
+	assert_equals(5u, stream.buffered());
+	assert_equals(1u, stream.expected());
+	const byte_t first_byte[] = { 1 };
+	stream.feed(first_byte, sizeof(first_byte));
+	assert_equals(2u, stream.pending());
+	frame f;
+	assert_true(stream.next(f));
+	assert_equals(4, f.id);
+	assert_true(stream.next(f));
+	assert_equals(5, f.id);
+	assert_false(stream.next(f));
+
+#ifndef PAKET_NO_EXCEPTIONS
+	// malformed id does not block the following frames
+	const byte_t bad_id[] = { 6, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01, 2, 4, 1 };
+	stream.feed(bad_id, sizeof(bad_id));
+	assert_equals(2u, stream.pending());
+	assert_fails_with(paket_error, {
+		stream.next(f);
+	});
+	assert_true(stream.next(f));
+	assert_equals(4, f.id);
+	assert_false(stream.next(f));
+#endif
+
+	const byte_t huge[] = { 0xff, 0xff, 0xff, 0x7f };
+	assert_fails_with(paket_error, {
+		stream.feed(huge, sizeof(huge));
+	});
+	stream.clear();
+	const byte_t partial[] = { 10, 1 };
+	stream.feed(partial, sizeof(partial));
+	assert_equals(9u, stream.expected());
+}
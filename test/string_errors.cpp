@@ -15,9 +15,14 @@ test {
 	assert_equals(-1, strp1.write(bytes, 3));
 	assert_equals(-1, strp1.write(bytes, 4));
 	assert_equals(8, strp1.write(bytes, 8));
-	bytes[0] = 0;
 	assert_equals(-1, strp2.read(bytes, 3));
 	assert_equals(-1, strp2.read(bytes, 4));
+	// empty frame has no room for the paket id
+	bytes[0] = 0;
+	assert_fails_with(paket_error, {
+		strp2.read(bytes, 3);
+	});
+	bytes[0] = 7;
 	bytes[3] = 255;
 	bytes[4] = 255;
 	bytes[5] = 255;
@@ -11,6 +11,7 @@
 #include <iostream>
 #include <functional>
 #include <vector>
+#include <cstdlib>
 
 namespace std {
     inline string to_string(const std::string & str) {
@@ -25,6 +26,15 @@ public:
     explicit assertion_error(const std::string & message) : std::runtime_error(message) {}
 };
 
+[[noreturn]] inline void fail(const std::string & message) {
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS)
+    throw assertion_error(message);
+#else
+    std::cout << message << std::endl;
+    std::abort();
+#endif
+}
+
 struct {
     int success = 0;
     template <typename first, typename second>
@@ -33,7 +43,7 @@ struct {
             std::string message = std::string(file) + ":" + std::to_string(line) + ": assertion failed (\"" + std::to_string(expect) +
             "\" expected, got \"" + std::to_string(actual) + "\")";
             std::cout << "test failed: " << message << std::endl;
-            throw assertion_error(message);
+            fail(message);
         } else
             success++;
     }
@@ -43,10 +53,11 @@ struct {
             std::string message = std::string(file) + ":" + std::to_string(line) + ": assertion failed (\"" + std::to_string(expect) +
             "\" equals to \"" + std::to_string(actual) + "\")";
             std::cout << "test failed: " << message << std::endl;
-            throw assertion_error(message);
+            fail(message);
         } else
             success++;
     }
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS)
     template <typename E, typename F>
     void assert_ex_with(F fun, const char * file, std::size_t line) {
         try {
@@ -61,7 +72,7 @@ struct {
         }
         std::string message = std::string(file) + ":" + std::to_string(line) + ": no exception cought.";
         std::cout << "test failed: " << message << std::endl;
-        throw assertion_error(message);
+        fail(message);
     }
     template <typename F>
     void assert_ex(F fun, const char * file, std::size_t line) {
@@ -73,15 +84,22 @@ struct {
         }
         std::string message = std::string(file) + ":" + std::to_string(line) + ": no exception cought.";
         std::cout << "test failed: " << message << std::endl;
-        throw assertion_error(message);
+        fail(message);
     }
+#else
+    // errors abort the program without exceptions, so such checks are skipped
+    template <typename E, typename F>
+    void assert_ex_with(F, const char *, std::size_t) {}
+    template <typename F>
+    void assert_ex(F, const char *, std::size_t) {}
+#endif
     void assert_tr(bool value, const char * file, std::size_t line, const char * expression) {
         if (value) {
             success++;
         } else {
             std::string message = std::string(file) + ":" + std::to_string(line) + ": value (" + expression + ") was false.";
             std::cout << "test failed: " << message << std::endl;
-            throw assertion_error(message);
+            fail(message);
         }
     }
     void assert_fa(bool value, const char * file, std::size_t line, const char * expression) {
@@ -90,7 +108,7 @@ struct {
         } else {
             std::string message = std::string(file) + ":" + std::to_string(line) + ": value (" + expression + ") was true.";
             std::cout << "test failed: " << message << std::endl;
-            throw assertion_error(message);
+            fail(message);
         }
     }
 } assert;
@@ -0,0 +1,101 @@
+#include <paket.hpp>
+
+#include "test.hpp"
+
+using namespace handtruth::pakets;
+
+struct login_paket : paket<3, fields::varint, fields::string, fields::list<std::int32_t>> {};
+
+test {
+	login_paket p;
+	p.field<0>() = 47;
+	p.field<1>() = "player";
+	p.field<2>() = { 1, 2, 3 };
+	std::array<byte_t, 64> bytes;
+	int size = p.write(bytes);
+
+	login_paket q;
+	read_result result = q.try_read(bytes, size);
+	assert_true(result.ok());
+	assert_equals(std::size_t(size), result.offset);
+	assert_equals(p, q);
+	assert_true(bool(login_paket::try_validate(bytes, size)));
+	assert_true(paket_errc::incomplete == q.try_read(bytes, size - 1).error);
+	assert_true(paket_errc::incomplete == login_paket::try_validate(bytes, size - 1).error);
+
+	// negative string length, offset points to the string field
+	std::array<byte_t, 64> bad = bytes;
+	bad[3] = 0xff;
+	bad[4] = 0xff;
+	bad[5] = 0xff;
+	bad[6] = 0xff;
+	bad[7] = 0x0f;
+	result = q.try_read(bad, size);
+	assert_true(paket_errc::negative_length == result.error);
+	assert_equals(std::size_t(3), result.offset);
+	assert_true(paket_errc::negative_length == login_paket::try_validate(bad, size).error);
+	assert_fails_with(paket_error, {
+		q.read(bad, size);
+	});
+
+	// too long varint in the first field
+	bad = bytes;
+	for (std::size_t i = 2; i < 8; ++i)
+		bad[i] = 0x80;
+	result = q.try_read(bad, size);
+	assert_true(paket_errc::varnum_too_big == result.error);
+	assert_equals(std::size_t(2), result.offset);
+
+	// negative list length
+	bad = bytes;
+	bad[10] = 0xff;
+	bad[11] = 0xff;
+	bad[12] = 0xff;
+	bad[13] = 0xff;
+	bad[14] = 0x0f;
+	bad[0] = static_cast<byte_t>(bad[0] + 1);
+	result = q.try_read(bad, size + 1);
+	assert_true(paket_errc::negative_length == result.error);
+	assert_equals(std::size_t(10), result.offset);
+
+	struct : paket<4, fields::varint, fields::string, fields::list<std::int32_t>> {} other;
+	result = other.try_read(bytes, size);
+	assert_true(paket_errc::wrong_id == result.error);
+	assert_equals(std::size_t(1), result.offset);
+#ifndef PAKET_NO_EXCEPTIONS
+	// message names both ids
+	std::string message;
+	try {
+		other.read(bytes, size);
+	} catch (const paket_error & e) {
+		message = e.what();
+	}
+	assert_equals(std::string("wrong paket id (4 expected, got 3)"), message);
+#endif
+
+	// string runs past the end of the complete frame
+	bad = bytes;
+	bad[0] = 4;
+	result = q.try_read(bad, 5);
+	assert_true(paket_errc::wrong_size == result.error);
+	assert_equals(std::size_t(3), result.offset);
+	assert_true(paket_errc::wrong_size == login_paket::try_validate(bad, 5).error);
+	assert_fails_with(paket_error, {
+		q.read(bad, 5);
+	});
+	// the same with bytes of the next frame after it
+	assert_true(paket_errc::wrong_size == q.try_read(bad, size).error);
+
+	bad = bytes;
+	bad[0] = static_cast<byte_t>(bad[0] - 1);
+	assert_true(paket_errc::wrong_size == q.try_read(bad, size).error);
+	assert_true(paket_errc::wrong_size == login_paket::try_validate(bad, size).error);
+	bad[0] = 0x7f;
+	bad[1] = 0x0f;
+	assert_true(paket_errc::incomplete == q.try_read(bad, size).error);
+
+	fields::varint field;
+	const byte_t long_varint[] = { 0x80, 0x80, 0x80, 0x80, 0x80, 0x01 };
+	assert_equals(int(paket_errc::varnum_too_big), field.try_read(long_varint, sizeof(long_varint)));
+	assert_equals(std::string("wrong paket id"), describe(paket_errc::wrong_id));
+}
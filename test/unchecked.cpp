@@ -0,0 +1,135 @@
+#include <paket.hpp>
+
+#include "test.hpp"
+
+#include <random>
+
+using namespace handtruth::pakets;
+
+struct keep_alive_paket : paket<33, fields::int64> {};
+struct position_paket : paket<0x11, fields::varint, fields::zint<std::int64_t>, fields::zint<std::int32_t>,
+	fields::zint<std::uint16_t>, fields::varlong, fields::float64, fields::boolean, fields::array<fields::int16, 3>> {};
+struct chat_paket : paket<0x0F, fields::string, fields::byte> {};
+
+static_assert(keep_alive_paket::is_bounded());
+static_assert(keep_alive_paket::min_size() == 8);
+static_assert(keep_alive_paket::max_size() == 8);
+static_assert(keep_alive_paket::max_frame_size() == 10);
+static_assert(position_paket::is_bounded());
+static_assert(position_paket::min_size() == 1 + 1 + 1 + 1 + 1 + 8 + 1 + 6);
+static_assert(position_paket::max_size() == 5 + 10 + 5 + 3 + 10 + 8 + 1 + 6);
+static_assert(!chat_paket::is_bounded());
+static_assert(chat_paket::min_size() == 2);
+
+test {
+	std::mt19937_64 random(3);
+	std::vector<byte_t> stream;
+	std::vector<position_paket> sent;
+	for (int i = 0; i < 1000; ++i) {
+		position_paket p;
+		int shift = i % 64;
+		p.field<0>() = static_cast<std::int32_t>(random() >> (32 + shift % 32));
+		p.field<1>() = static_cast<std::int64_t>(random() >> 2) >> shift;
+		if (i % 2)
+			p.field<1>() = -p.field<1>();
+		p.field<2>() = static_cast<std::int32_t>(random() >> (34 + shift % 30)) * (i % 3 ? 1 : -1);
+		p.field<3>() = static_cast<std::uint16_t>(random() >> (48 + shift % 16));
+		p.field<4>() = static_cast<std::int64_t>(random() >> shift);
+		p.field<5>() = i * 0.25;
+		p.field<6>() = i % 5 == 0;
+		p.field<7>() = { std::int16_t(i), std::int16_t(-i), 7 };
+
+		std::array<byte_t, position_paket::max_frame_size()> checked, unchecked;
+		int size = p.write(checked);
+		assert_equals(size, p.write_unchecked(unchecked));
+		assert_true(std::equal(checked.begin(), checked.begin() + size, unchecked.begin()));
+
+		// exact buffer takes the checked path for the body
+		position_paket decoded;
+		assert_equals(size, decoded.read_unchecked(unchecked.data(), size));
+		assert_true(p == decoded);
+
+		stream.insert(stream.end(), unchecked.begin(), unchecked.begin() + size);
+		sent.push_back(p);
+	}
+	std::size_t offset = 0;
+	for (const position_paket & expected : sent) {
+		position_paket decoded;
+		int size = decoded.read_unchecked(stream.data() + offset, stream.size() - offset);
+		assert_true(size > 0);
+		assert_true(expected == decoded);
+		offset += size;
+	}
+	assert_equals(stream.size(), offset);
+
+	// small buffer works as write()
+	keep_alive_paket keep_alive;
+	keep_alive.field<0>() = -5;
+	byte_t bytes[64];
+	assert_equals(-1, keep_alive.write_unchecked(bytes, 9));
+	assert_equals(10, keep_alive.write_unchecked(bytes, sizeof(bytes)));
+	assert_equals(-1, keep_alive.read_unchecked(bytes, 9));
+	keep_alive_paket keep_alive_decoded;
+	assert_equals(10, keep_alive_decoded.read_unchecked(bytes, sizeof(bytes)));
+	assert_equals(std::int64_t(-5), keep_alive_decoded.field<0>());
+
+	// padded frame length
+	int padded = keep_alive.write_once(bytes, sizeof(bytes), length_encoding::padded5);
+	assert_equals(14, padded);
+	assert_equals(padded, keep_alive_decoded.read_unchecked(bytes, sizeof(bytes)));
+
+	// malformed frames
+	position_paket p = sent[0];
+	int size = p.write(bytes, sizeof(bytes));
+	bytes[size] = 0;
+	bytes[0] -= 1;
+	assert_fails_with(paket_error, {
+		p.read_unchecked(bytes, sizeof(bytes));
+	});
+	bytes[0] += 1;
+	bytes[1] = 0x12;
+	assert_fails_with(paket_error, {
+		p.read_unchecked(bytes, sizeof(bytes));
+	});
+	byte_t too_big[64] = { 12, 0x11, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f };
+	assert_fails_with(paket_error, {
+		p.read_unchecked(too_big, sizeof(too_big));
+	});
+
+	// bytes after the frame do not change the result
+	size = p.write(bytes, sizeof(bytes));
+	std::fill(bytes + size, bytes + sizeof(bytes), 0xff);
+	position_paket decoded;
+	assert_equals(size, decoded.read_unchecked(bytes, sizeof(bytes)));
+	assert_true(p == decoded);
+	// frame ends inside the first varint, the following bytes would make it too big
+	byte_t cut[64] = { 3, 0x11, 0x80, 0x80 };
+	std::fill(cut + 4, cut + sizeof(cut), 0xff);
+	read_result result = decoded.try_read(cut, sizeof(cut));
+	assert_true(result.error == paket_errc::wrong_size);
+#ifndef PAKET_NO_EXCEPTIONS
+	std::string checked_error, unchecked_error;
+	try {
+		decoded.read(cut, sizeof(cut));
+	} catch (const paket_error & e) {
+		checked_error = e.what();
+	}
+	try {
+		decoded.read_unchecked(cut, sizeof(cut));
+	} catch (const paket_error & e) {
+		unchecked_error = e.what();
+	}
+	assert_false(checked_error.empty());
+	assert_equals(checked_error, unchecked_error);
+#endif
+
+	// minimum values of zint fields
+	p.field<1>() = std::numeric_limits<std::int64_t>::min();
+	p.field<2>() = std::numeric_limits<std::int32_t>::min();
+	size = p.write_unchecked(bytes, sizeof(bytes));
+	byte_t checked[64];
+	assert_equals(size, p.write(checked, sizeof(checked)));
+	assert_true(std::equal(bytes, bytes + size, checked));
+	assert_equals(size, decoded.read_unchecked(bytes, sizeof(bytes)));
+	assert_true(p == decoded);
+}
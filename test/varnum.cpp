@@ -0,0 +1,81 @@
+#include <paket.hpp>
+
+#include "test.hpp"
+
+#include <random>
+
+using namespace handtruth::pakets;
+
+template <typename numeric>
+int reference_read_varnum(numeric & value, const byte_t bytes[], std::size_t length) {
+	typedef std::make_unsigned_t<numeric> unsigned_t;
+	std::size_t numRead = 0;
+	byte_t read;
+	unsigned_t result = 0;
+	do {
+		if (numRead == length)
+			return -1;
+		read = bytes[numRead];
+		if (numRead == max_varnum_size<numeric>())
+			return -2;
+		unsigned_t tmp = (read & 0b01111111);
+		result |= (tmp << (7 * numRead));
+		numRead++;
+	} while ((read & 0b10000000) != 0);
+	value = static_cast<numeric>(result);
+	return numRead;
+}
+
+template <typename numeric>
+int checked_read_varnum(numeric & value, const byte_t bytes[], std::size_t length) {
+	int s = try_read_varnum(value, bytes, length);
+	if (s == int(paket_errc::varnum_too_big)) {
+		assert_fails_with(paket_error, {
+			read_varnum(value, bytes, length);
+		});
+		return -2;
+	}
+	assert_equals(s, read_varnum(value, bytes, length));
+	return s;
+}
+
+template <typename numeric>
+void compare_all(const byte_t bytes[], std::size_t length) {
+	for (std::size_t l = 0; l <= length; ++l) {
+		numeric expected = 0, actual = 0;
+		int e = reference_read_varnum(expected, bytes, l);
+		int a = checked_read_varnum(actual, bytes, l);
+		assert_equals(e, a);
+		if (e > 0)
+			assert_equals(expected, actual);
+	}
+}
+
+test {
+	std::mt19937_64 random(42);
+	std::array<byte_t, 16> mem {};
+	for (int i = 0; i < 20000; ++i) {
+		std::uint64_t value = random() >> (random() % 64);
+		write_varnum(value, mem.data(), mem.size());
+		compare_all<std::int32_t>(mem.data(), mem.size());
+		compare_all<std::int64_t>(mem.data(), mem.size());
+		compare_all<std::uint16_t>(mem.data(), mem.size());
+		for (auto & each : mem)
+			each = static_cast<byte_t>(random() | (random() % 4 ? 0x80 : 0));
+		compare_all<std::int32_t>(mem.data(), mem.size());
+		compare_all<std::int64_t>(mem.data(), mem.size());
+	}
+	std::int32_t varint;
+	std::int64_t varlong;
+	assert_equals(5, write_varint(-1, mem.data(), mem.size()));
+	assert_equals(5, read_varint(varint, mem.data(), mem.size()));
+	assert_equals(-1, varint);
+	assert_equals(10, write_varlong(mem.data(), mem.size(), -1));
+	assert_equals(10, read_varlong(mem.data(), mem.size(), varlong));
+	assert_equals(-1, varlong);
+	mem.fill(0xff);
+	assert_fails_with(paket_error, {
+		read_varint(varint, mem.data(), mem.size());
+	});
+	assert_equals(-1, read_varint(varint, mem.data(), 5));
+}
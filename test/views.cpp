@@ -0,0 +1,38 @@
+#include <paket.hpp>
+
+#include "test.hpp"
+
+#include <algorithm>
+
+using namespace handtruth::pakets;
+
+struct chat_paket : paket<15, fields::string, fields::list<std::string>, fields::rest> {};
+struct chat_view_paket : paket<15, fields::string_view, fields::list<std::string_view>, fields::bytes_view> {};
+
+test {
+	chat_paket p1;
+	p1.field<0>() = "message";
+	p1.field<1>() = { fields::string("first"), fields::string("second") };
+	p1.field<2>() = { 1, 2, 3, 4 };
+	byte_t bytes[100];
+	int size = p1.write(bytes, sizeof(bytes));
+	chat_view_paket p2;
+	assert_equals(size, p2.read(bytes, size));
+	assert_equals("message", std::string(p2.field<0>()));
+	assert_true(reinterpret_cast<const byte_t *>(p2.field<0>().data()) > bytes);
+	assert_true(reinterpret_cast<const byte_t *>(p2.field<0>().data()) < bytes + size);
+	assert_equals(2u, p2.field<1>().size());
+	assert_equals("second", std::string(p2.field<1>()[1].value));
+	assert_equals(4u, p2.field<2>().size());
+	assert_true(p2.field<2>().data() == bytes + size - 4);
+	assert_equals(p1.size(), p2.size());
+	assert_equals("#15:{ \"message\", [\"first\", \"second\"], <bytes> }", std::to_string(p2));
+	byte_t copy[100];
+	assert_equals(size, p2.write(copy, sizeof(copy)));
+	assert_true(std::equal(bytes, bytes + size, copy));
+	assert_equals(-1, p2.write(copy, size - 1));
+	bytes[1] = 0;
+	assert_fails_with(paket_error, {
+		p2.read(bytes, size);
+	});
+}
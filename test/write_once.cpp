@@ -0,0 +1,77 @@
+#include <paket_sink.hpp>
+
+#include "test.hpp"
+
+#include <algorithm>
+
+using namespace handtruth::pakets;
+
+struct chunk_paket : paket<32, fields::varint, fields::list<std::string>, fields::rest> {};
+
+test {
+	chunk_paket p;
+	p.field<0>() = 7;
+	p.field<1>() = { fields::string("a"), fields::string("bb") };
+	p.field<2>().assign(300, 0x55);
+	std::vector<byte_t> expected(400);
+	int size = p.write(expected.data(), expected.size());
+	expected.resize(size);
+
+	std::vector<byte_t> bytes(400);
+	assert_equals(size, p.write_once(bytes.data(), bytes.size(), length_encoding::minimal));
+	assert_true(std::equal(expected.begin(), expected.end(), bytes.begin()));
+	// buffer of exactly the frame size has no room for the longest length slot
+	std::vector<byte_t> exact(size);
+	assert_equals(size, p.write_once(exact.data(), exact.size(), length_encoding::minimal));
+	assert_true(expected == exact);
+	assert_equals(-1, p.write_once(exact.data(), exact.size() - 1, length_encoding::minimal));
+	chunk_paket tiny;
+	byte_t tiny_bytes[4];
+	assert_equals(4, tiny.write_once(tiny_bytes, sizeof(tiny_bytes), length_encoding::minimal));
+
+	for (auto encoding : { length_encoding::padded3, length_encoding::padded5 }) {
+		std::size_t slot = static_cast<std::size_t>(encoding);
+		int padded = p.write_once(bytes.data(), bytes.size(), encoding);
+		assert_equals(size - 2 + int(slot), padded);
+		chunk_paket q;
+		assert_equals(padded, q.read(bytes.data(), padded));
+		assert_equals(p, q);
+		assert_equals(-1, p.write_once(bytes.data(), padded - 1, encoding));
+		// neither the length slot nor a part of the body stays in the sink
+		std::vector<byte_t> small(padded - 1);
+		arena_sink arena(small.data(), small.size());
+		assert_equals(-1, p.write_once(arena, encoding));
+		assert_equals(0u, arena.size());
+
+		vector_sink out(16);
+		chain_sink chain(64);
+		for (int i = 0; i < 10; ++i) {
+			assert_equals(padded, p.write_once(out, encoding));
+			assert_equals(padded, p.write_once(chain, encoding));
+		}
+		auto collected = chain.collect();
+		for (int i = 0; i < 10; ++i) {
+			assert_true(std::equal(bytes.begin(), bytes.begin() + padded, out.data() + i * padded));
+			assert_true(std::equal(bytes.begin(), bytes.begin() + padded, collected.begin() + i * padded));
+		}
+	}
+
+	std::array<byte_t, 8> mem;
+	assert_equals(3, write_varnum_padded(1, mem.data(), 3));
+	std::int32_t value;
+	assert_equals(3, read_varint(value, mem.data(), 3));
+	assert_equals(1, value);
+	assert_equals(-1, write_varnum_padded(1 << 21, mem.data(), 3));
+
+	p.field<2>().assign(1 << 21, 0);
+	std::vector<byte_t> huge(p.size() + 10);
+	assert_fails_with(paket_error, {
+		p.write_once(huge.data(), huge.size());
+	});
+	assert_true(p.write_once(huge.data(), huge.size(), length_encoding::padded5) > 0);
+	vector_sink out;
+	assert_fails_with(paket_error, {
+		p.write_once(out);
+	});
+	assert_equals(0u, out.size());
+}
@@ -0,0 +1,73 @@
+#include <paket_zlib.hpp>
+
+#include "test.hpp"
+
+using namespace handtruth::pakets;
+
+struct chunk_paket : paket<34, fields::varint, fields::varint, fields::rest> {};
+struct keep_alive_paket : paket<33, fields::int64> {};
+
+test {
+	compression_codec codec(256);
+	chunk_paket chunk;
+	chunk.field<0>() = 5;
+	chunk.field<1>() = -7;
+	for (int i = 0; i < 5000; ++i)
+		chunk.field<2>().push_back(static_cast<byte_t>(i % 16));
+	keep_alive_paket keep_alive;
+	keep_alive.field<0>() = 1234567890123;
+
+	vector_sink out;
+	int chunk_size = codec.write(chunk, out);
+	assert_true(chunk_size > 0);
+	assert_true(std::size_t(chunk_size) < chunk.size() / 4);
+	int keep_alive_size = codec.write(keep_alive, out);
+	assert_equals(int(keep_alive.size() + 3), keep_alive_size);
+	assert_equals(std::size_t(chunk_size + keep_alive_size), out.size());
+
+	chunk_paket chunk2;
+	assert_equals(chunk_size, codec.read(chunk2, out.data(), out.size()));
+	assert_equals(chunk, chunk2);
+	keep_alive_paket keep_alive2;
+	const byte_t * second = out.data() + chunk_size;
+	assert_equals(keep_alive_size, codec.read(keep_alive2, second, keep_alive_size));
+	assert_equals(keep_alive, keep_alive2);
+	assert_equals(-1, codec.read(chunk2, out.data(), chunk_size - 1));
+	assert_fails_with(paket_error, {
+		codec.read(chunk2, second, keep_alive_size);
+	});
+
+	std::pmr::monotonic_buffer_resource arena;
+	frame f;
+	assert_equals(chunk_size, codec.read_frame(out.data(), out.size(), f, &arena));
+	assert_equals(34, f.id);
+	assert_equals(chunk.size(), f.body.size());
+	assert_equals(keep_alive_size, codec.read_frame(second, keep_alive_size, f));
+	assert_true(f.body.data() > second && f.body.data() < second + keep_alive_size);
+
+	// pakets below threshold are encoded directly, the same as through write_frame()
+	std::vector<byte_t> plain(keep_alive.size() + 10);
+	int plain_size = keep_alive.write(plain.data(), plain.size());
+	std::int32_t frame_size, id;
+	int k = head(plain.data(), plain_size, frame_size, id);
+	vector_sink expected;
+	assert_equals(keep_alive_size, codec.write_frame(plain.data() + k, frame_size, expected));
+	assert_true(std::equal(second, second + keep_alive_size, expected.data()));
+	chunk_paket small_chunk;
+	small_chunk.field<2>().assign(20, 1);
+	byte_t tiny[16];
+	arena_sink small(tiny, sizeof(tiny));
+	assert_equals(-1, codec.write(small_chunk, small));
+	assert_equals(0u, small.size());
+
+	// data length below threshold is not allowed for compressed frames
+	compression_codec strict(10000);
+	assert_fails_with(paket_error, {
+		strict.read_frame(out.data(), out.size(), f);
+	});
+	std::vector<byte_t> broken(out.data(), out.data() + chunk_size);
+	broken[10] ^= 0xff;
+	assert_fails_with(paket_error, {
+		codec.read_frame(broken.data(), broken.size(), f);
+	});
+}